@@ -0,0 +1,296 @@
+/**
+ * @file boot_profiler.c
+ * @brief Boot phase timing implementation
+ */
+
+#include "boot_profiler.h"
+#include "http_server.h"
+#include "json_writer.h"
+#include <zephyr/settings/settings.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/logging/log.h>
+#include <stdlib.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(boot_profiler, LOG_LEVEL_INF);
+
+#define BOOT_PROFILER_HISTORY CONFIG_SLIDER_BOOT_PROFILE_HISTORY
+
+/* Profile being recorded during this boot */
+static struct boot_profile current;
+static bool finished;
+
+/* Finished boots, slot seq % BOOT_PROFILER_HISTORY; seq 0 marks an empty slot */
+static struct boot_profile history[BOOT_PROFILER_HISTORY];
+static uint32_t newest_seq;
+
+/**
+ * @brief Get the time since reset in microseconds
+ *
+ * The RP2040 system timer counts at 1 MHz, so the 32-bit counter only
+ * wraps after about 71 minutes, well past the end of any boot.
+ */
+static uint32_t boot_profiler_now_us(void)
+{
+#ifdef CONFIG_TIMER_HAS_64BIT_CYCLE_COUNTER
+	return (uint32_t)k_cyc_to_us_floor64(k_cycle_get_64());
+#else
+	return (uint32_t)k_cyc_to_us_floor64(k_cycle_get_32());
+#endif
+}
+
+void boot_profiler_mark(const char *name)
+{
+	uint32_t now = boot_profiler_now_us();
+	struct boot_profile_phase *phase;
+
+	if (finished || current.phase_count >= BOOT_PROFILER_MAX_PHASES) {
+		return;
+	}
+
+	phase = &current.phases[current.phase_count];
+	strncpy(phase->name, name, BOOT_PROFILER_NAME_MAX);
+	phase->name[BOOT_PROFILER_NAME_MAX] = '\0';
+	phase->us = now;
+	current.phase_count++;
+
+	/* Earlier boots are only known once settings are loaded */
+	current.seq = newest_seq + 1;
+}
+
+void boot_profiler_finish(void)
+{
+	struct boot_profile *slot;
+
+	if (finished) {
+		return;
+	}
+
+	current.seq = newest_seq + 1;
+	current.complete = true;
+	finished = true;
+
+	slot = &history[current.seq % BOOT_PROFILER_HISTORY];
+	*slot = current;
+	newest_seq = current.seq;
+
+	LOG_INF("Boot #%u took %u ms over %u phases", current.seq,
+	        current.phase_count ?
+	        current.phases[current.phase_count - 1].us / 1000 : 0,
+	        current.phase_count);
+
+#ifdef CONFIG_SLIDER_BOOT_PROFILE_PERSIST
+	/* One key per slot, so each boot rewrites a single small record */
+	char key[24];
+	int rc;
+
+	snprintk(key, sizeof(key), "perf/boot/%u",
+	         (unsigned int)(current.seq % BOOT_PROFILER_HISTORY));
+	rc = settings_save_one(key, slot, sizeof(*slot));
+	if (rc) {
+		LOG_WRN("Failed to save boot profile: %d", rc);
+	}
+#endif
+}
+
+const struct boot_profile *boot_profiler_get(size_t index)
+{
+	const struct boot_profile *profile;
+	uint32_t seq;
+
+	if (!finished) {
+		if (index == 0) {
+			return &current;
+		}
+		index--;
+	}
+
+	if (index >= BOOT_PROFILER_HISTORY || index >= newest_seq) {
+		return NULL;
+	}
+
+	seq = newest_seq - index;
+	profile = &history[seq % BOOT_PROFILER_HISTORY];
+
+	/* A slot may hold an older boot if a save was lost */
+	return profile->seq == seq ? profile : NULL;
+}
+
+size_t boot_profiler_count(void)
+{
+	size_t count = 0;
+
+	while (boot_profiler_get(count)) {
+		count++;
+	}
+
+	return count;
+}
+
+#ifdef CONFIG_SLIDER_BOOT_PROFILE_PERSIST
+/*
+ * Settings handler: Set (called for each "perf/boot/<slot>" record)
+ */
+static int boot_profiler_handle_set(const char *name, size_t len,
+                                    settings_read_cb read_cb, void *cb_arg)
+{
+	struct boot_profile profile;
+	unsigned long slot;
+	char *end;
+	ssize_t rc;
+
+	if (strncmp(name, "boot/", 5) != 0) {
+		return -ENOENT;
+	}
+
+	slot = strtoul(name + 5, &end, 10);
+	if (*end != '\0') {
+		return -ENOENT;
+	}
+
+	/* Records from another build or history size are dropped */
+	if (len != sizeof(profile) || slot >= BOOT_PROFILER_HISTORY) {
+		return 0;
+	}
+
+	rc = read_cb(cb_arg, &profile, sizeof(profile));
+	if (rc < 0) {
+		return rc;
+	}
+
+	if (profile.seq == 0 || profile.seq % BOOT_PROFILER_HISTORY != slot ||
+	    profile.phase_count > BOOT_PROFILER_MAX_PHASES) {
+		return 0;
+	}
+
+	for (uint8_t i = 0; i < profile.phase_count; i++) {
+		profile.phases[i].name[BOOT_PROFILER_NAME_MAX] = '\0';
+	}
+
+	history[slot] = profile;
+	if (profile.seq > newest_seq) {
+		newest_seq = profile.seq;
+	}
+
+	return 0;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(boot_profiler_handler, "perf",
+                               NULL,                      /* h_get */
+                               boot_profiler_handle_set,  /* h_set */
+                               NULL,                      /* h_commit */
+                               NULL);                     /* h_export */
+#endif /* CONFIG_SLIDER_BOOT_PROFILE_PERSIST */
+
+/**
+ * @brief Shell command: Show boot phase timings
+ */
+static int cmd_perf_boot(const struct shell *sh, size_t argc, char **argv)
+{
+	size_t count = boot_profiler_count();
+
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	if (count == 0) {
+		shell_print(sh, "No boot profiles recorded");
+		return 0;
+	}
+
+	for (size_t b = 0; b < count; b++) {
+		const struct boot_profile *profile = boot_profiler_get(b);
+		uint32_t prev = 0;
+
+		shell_print(sh, "Boot #%u%s", profile->seq,
+		            profile->complete ? "" : " (in progress)");
+		shell_print(sh, "  %-16s %12s %12s", "Phase", "At (ms)", "Delta (ms)");
+
+		for (uint8_t i = 0; i < profile->phase_count; i++) {
+			const struct boot_profile_phase *phase = &profile->phases[i];
+			uint32_t delta = phase->us - prev;
+
+			shell_print(sh, "  %-16s %8u.%03u %8u.%03u", phase->name,
+			            phase->us / 1000, phase->us % 1000,
+			            delta / 1000, delta % 1000);
+			prev = phase->us;
+		}
+
+		shell_print(sh, "");
+	}
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(perf_cmds,
+	SHELL_CMD(boot, NULL, "Show boot phase timings", cmd_perf_boot),
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(perf, &perf_cmds, "Performance counters", NULL);
+
+/**
+ * @brief Encode one fragment of the /api/v1/perf/boot document
+ *
+ * The document is {"boots": [{"seq", "complete", "phases": [...]}, ...]}
+ * with the current boot first. Fragment indices walk it in order: the
+ * opening, then for each boot its header, one fragment per phase and its
+ * closing, and finally the closing of the list.
+ */
+static bool boot_profiler_render(struct json_writer *w, size_t index)
+{
+	const struct boot_profile *profile;
+
+	if (index == 0) {
+		json_writer_object_start(w, NULL);
+		json_writer_array_start(w, "boots");
+		return true;
+	}
+	index--;
+
+	for (size_t b = 0; (profile = boot_profiler_get(b)) != NULL; b++) {
+		size_t items = profile->phase_count + 2U;
+
+		if (index >= items) {
+			index -= items;
+			continue;
+		}
+
+		if (index == 0) {
+			json_writer_init(w, w->buf, w->size, b > 0);
+			json_writer_object_start(w, NULL);
+			json_writer_int(w, "seq", profile->seq);
+			json_writer_bool(w, "complete", profile->complete);
+			json_writer_array_start(w, "phases");
+		} else if (index <= profile->phase_count) {
+			const struct boot_profile_phase *phase = &profile->phases[index - 1];
+			uint32_t prev = index > 1 ? profile->phases[index - 2].us : 0;
+
+			json_writer_init(w, w->buf, w->size, index > 1);
+			json_writer_object_start(w, NULL);
+			json_writer_string(w, "name", phase->name);
+			json_writer_int(w, "us", phase->us);
+			json_writer_int(w, "delta_us", phase->us - prev);
+			json_writer_object_end(w);
+		} else {
+			json_writer_array_end(w);
+			json_writer_object_end(w);
+		}
+		return true;
+	}
+
+	if (index == 0) {
+		json_writer_array_end(w);
+		json_writer_object_end(w);
+		return true;
+	}
+
+	return false;
+}
+
+static void boot_profiler_api_get(struct http_server *server, struct http_conn *conn)
+{
+	http_server_respond_json(server, conn, 200, boot_profiler_render);
+}
+
+HTTP_ROUTE_DEFINE(http_route_perf_boot, HTTP_METHOD_GET, "/api/v1/perf/boot",
+                  boot_profiler_api_get);
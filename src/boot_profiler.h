@@ -0,0 +1,84 @@
+/**
+ * @file boot_profiler.h
+ * @brief Boot phase timing
+ *
+ * Records when each named phase of the boot sequence completes (flash,
+ * settings, interface up, association, DHCP, HTTP server ready), using
+ * the hardware cycle counter. The last few boots are kept in a RAM ring
+ * and, when CONFIG_SLIDER_BOOT_PROFILE_PERSIST is enabled, saved to
+ * settings so regressions can be compared across resets.
+ *
+ * The history is shown by the 'perf boot' shell command and served as
+ * JSON on GET /api/v1/perf/boot.
+ */
+
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Phases recorded per boot; further marks are dropped */
+#define BOOT_PROFILER_MAX_PHASES 12
+
+/** Longest phase name, excluding the NUL */
+#define BOOT_PROFILER_NAME_MAX 15
+
+/**
+ * @brief One completed phase
+ */
+struct boot_profile_phase {
+	char name[BOOT_PROFILER_NAME_MAX + 1];
+	uint32_t us;            /**< Time since reset (us) */
+};
+
+/**
+ * @brief Phase timings of one boot
+ */
+struct boot_profile {
+	uint32_t seq;           /**< Boot number, counted by the profiler */
+	uint8_t phase_count;
+	bool complete;          /**< boot_profiler_finish() was reached */
+	struct boot_profile_phase phases[BOOT_PROFILER_MAX_PHASES];
+};
+
+/**
+ * @brief Record the end of a boot phase
+ *
+ * Cheap enough to call from anywhere in the boot path. Does nothing
+ * once the boot is finished, so code shared with later shell commands
+ * can mark phases unconditionally.
+ *
+ * @param name Phase name, truncated to BOOT_PROFILER_NAME_MAX characters
+ */
+void boot_profiler_mark(const char *name);
+
+/**
+ * @brief Close the current boot's profile
+ *
+ * Adds it to the history and persists the history if enabled. Must be
+ * called after settings_load() so earlier boots are not overwritten.
+ */
+void boot_profiler_finish(void);
+
+/**
+ * @brief Get the number of boots available
+ *
+ * @return Profiles in the history, plus the current one while unfinished
+ */
+size_t boot_profiler_count(void);
+
+/**
+ * @brief Get a boot profile
+ *
+ * @param index 0 for the current boot, 1 for the one before, ...
+ * @return Profile, or NULL if index >= boot_profiler_count()
+ */
+const struct boot_profile *boot_profiler_get(size_t index);
+
+#ifdef __cplusplus
+}
+#endif
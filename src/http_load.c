@@ -0,0 +1,303 @@
+/**
+ * @file http_load.c
+ * @brief HTTP server load benchmark implementation
+ */
+
+#include "http_load.h"
+#include <zephyr/net/socket.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HTTP_LOAD_TIMEOUT_MS 5000
+
+BUILD_ASSERT(HTTP_LOAD_MAX_CLIENTS >= 1,
+             "No sockets left for HTTP load clients; raise CONFIG_ZVFS_OPEN_MAX "
+             "and CONFIG_NET_MAX_CONTEXTS");
+
+/* Where a client is in the response it is reading */
+enum http_load_phase {
+	HTTP_LOAD_HEADER,       /* Status line and header fields */
+	HTTP_LOAD_BODY,         /* Content-Length body */
+	HTTP_LOAD_CHUNK_SIZE,   /* Chunk-size line, or the CRLF ending a chunk */
+	HTTP_LOAD_CHUNK_DATA,   /* Chunk data */
+	HTTP_LOAD_TRAILER,      /* Trailer fields after the last chunk */
+	HTTP_LOAD_DONE
+};
+
+/* One benchmark client: a keep-alive connection issuing requests in turn */
+struct http_load_client {
+	int sock;
+	int sent;               /* Requests sent so far */
+	uint32_t start;         /* Cycle count the pending request was sent at */
+	uint32_t body_left;     /* Bytes still to come of the body or chunk */
+	enum http_load_phase phase;
+	bool chunked;
+	uint8_t line_len;       /* Length of the line so far, saturating */
+	char line[32];          /* Start of the line, lowercased */
+};
+
+static struct http_load_client http_load_clients[HTTP_LOAD_MAX_CLIENTS];
+static uint32_t http_load_samples[HTTP_LOAD_MAX_SAMPLES];
+
+/**
+ * @brief Act on one complete line of a response
+ */
+static void http_load_line(struct http_load_client *c)
+{
+	/* A line too long to keep is a field the client does not look at */
+	if (c->line_len >= sizeof(c->line)) {
+		return;
+	}
+	c->line[c->line_len] = '\0';
+
+	switch (c->phase) {
+	case HTTP_LOAD_HEADER:
+		if (c->line_len > 0) {
+			if (strncmp(c->line, "content-length:", 15) == 0) {
+				c->body_left = strtoul(c->line + 15, NULL, 10);
+			} else if (strncmp(c->line, "transfer-encoding:", 18) == 0) {
+				c->chunked = strstr(c->line + 18, "chunked") != NULL;
+			}
+		} else if (c->chunked) {
+			c->phase = HTTP_LOAD_CHUNK_SIZE;
+		} else {
+			c->phase = c->body_left ? HTTP_LOAD_BODY : HTTP_LOAD_DONE;
+		}
+		break;
+	case HTTP_LOAD_CHUNK_SIZE:
+		/* The CRLF after chunk data reads as an empty line */
+		if (c->line_len > 0) {
+			c->body_left = strtoul(c->line, NULL, 16);
+			c->phase = c->body_left ? HTTP_LOAD_CHUNK_DATA : HTTP_LOAD_TRAILER;
+		}
+		break;
+	case HTTP_LOAD_TRAILER:
+		if (c->line_len == 0) {
+			c->phase = HTTP_LOAD_DONE;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * @brief Consume response bytes
+ *
+ * @return true once the response is complete
+ */
+static bool http_load_consume(struct http_load_client *c, const char *buf, size_t len)
+{
+	size_t i = 0;
+
+	while (i < len && c->phase != HTTP_LOAD_DONE) {
+		char ch;
+
+		if (c->phase == HTTP_LOAD_BODY || c->phase == HTTP_LOAD_CHUNK_DATA) {
+			uint32_t n = MIN(c->body_left, len - i);
+
+			c->body_left -= n;
+			i += n;
+			if (c->body_left == 0) {
+				c->phase = (c->phase == HTTP_LOAD_BODY) ?
+				           HTTP_LOAD_DONE : HTTP_LOAD_CHUNK_SIZE;
+			}
+			continue;
+		}
+
+		ch = buf[i++];
+		if (ch == '\r') {
+			continue;
+		}
+
+		if (ch != '\n') {
+			if (c->line_len < sizeof(c->line) - 1) {
+				c->line[c->line_len] = (ch >= 'A' && ch <= 'Z') ? ch + ('a' - 'A') : ch;
+			}
+			if (c->line_len < UINT8_MAX) {
+				c->line_len++;
+			}
+			continue;
+		}
+
+		http_load_line(c);
+		c->line_len = 0;
+	}
+
+	return c->phase == HTTP_LOAD_DONE;
+}
+
+/**
+ * @brief Send the next request of a client
+ */
+static int http_load_send(struct http_load_client *c, const char *path)
+{
+	char req[96];
+	int len = snprintf(req, sizeof(req), "GET %s HTTP/1.1\r\nHost: slider\r\n\r\n", path);
+
+	if ((size_t)len >= sizeof(req)) {
+		return -ENAMETOOLONG;
+	}
+
+	c->phase = HTTP_LOAD_HEADER;
+	c->chunked = false;
+	c->body_left = 0;
+	c->line_len = 0;
+	c->start = k_cycle_get_32();
+	c->sent++;
+
+	return (send(c->sock, req, len, 0) == len) ? 0 : -EIO;
+}
+
+static int http_load_cmp(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+int http_load_run(const struct shell *sh, struct http_server *server,
+                  const struct in_addr *addr, int clients, int requests,
+                  const char *path)
+{
+	struct sockaddr_in sin = {
+		.sin_family = AF_INET,
+		.sin_port = htons(HTTP_SERVER_PORT),
+	};
+	struct pollfd fds[HTTP_LOAD_MAX_CLIENTS];
+	struct http_server_stats before, after;
+	uint32_t responses, sends;
+	static char buf[512];
+	size_t samples = 0;
+	int active = 0, errors = 0;
+	uint64_t sum = 0;
+	int64_t elapsed_us;
+	int64_t start;
+
+	if (clients <= 0 || clients > HTTP_LOAD_MAX_CLIENTS || requests <= 0 ||
+	    clients * requests > HTTP_LOAD_MAX_SAMPLES) {
+		shell_error(sh, "Usage: demo http_load [clients 1-%d] [requests] [path], "
+		            "at most %d requests in all", HTTP_LOAD_MAX_CLIENTS,
+		            HTTP_LOAD_MAX_SAMPLES);
+		return -EINVAL;
+	}
+
+	if (server->state != HTTP_SERVER_RUNNING) {
+		shell_error(sh, "HTTP server is not running");
+		return -ENODEV;
+	}
+
+	/* Without an address of its own (native_sim), use loopback */
+	if (addr) {
+		sin.sin_addr = *addr;
+	} else {
+		(void)net_addr_pton(AF_INET, "127.0.0.1", &sin.sin_addr);
+	}
+
+	http_server_get_stats(server, &before);
+	start = k_uptime_ticks();
+
+	for (int i = 0; i < clients; i++) {
+		struct http_load_client *c = &http_load_clients[i];
+
+		memset(c, 0, sizeof(*c));
+		c->sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+		if (c->sock < 0 ||
+		    connect(c->sock, (struct sockaddr *)&sin, sizeof(sin)) < 0 ||
+		    http_load_send(c, path) < 0) {
+			shell_error(sh, "Client %d could not connect: %d", i, errno);
+			if (c->sock >= 0) {
+				close(c->sock);
+			}
+			c->sock = -1;
+			errors++;
+			continue;
+		}
+		active++;
+	}
+
+	while (active > 0) {
+		int ret;
+
+		for (int i = 0; i < clients; i++) {
+			fds[i].fd = http_load_clients[i].sock;
+			fds[i].events = POLLIN;
+			fds[i].revents = 0;
+		}
+
+		ret = poll(fds, clients, HTTP_LOAD_TIMEOUT_MS);
+		if (ret <= 0) {
+			shell_error(sh, "No response within %d ms", HTTP_LOAD_TIMEOUT_MS);
+			errors += active;
+			break;
+		}
+
+		for (int i = 0; i < clients; i++) {
+			struct http_load_client *c = &http_load_clients[i];
+			ssize_t len;
+
+			if (c->sock < 0 || fds[i].revents == 0) {
+				continue;
+			}
+
+			len = recv(c->sock, buf, sizeof(buf), 0);
+			if (len > 0 && !http_load_consume(c, buf, len)) {
+				continue;
+			}
+
+			if (len > 0) {
+				uint32_t us = k_cyc_to_us_floor32(k_cycle_get_32() - c->start);
+
+				http_load_samples[samples++] = us;
+				sum += us;
+				if (c->sent < requests && http_load_send(c, path) == 0) {
+					continue;
+				}
+				if (c->sent < requests) {
+					errors++;
+				}
+			} else {
+				/* Closed or failed before the response was complete */
+				errors++;
+			}
+
+			close(c->sock);
+			c->sock = -1;
+			active--;
+		}
+	}
+
+	elapsed_us = k_ticks_to_us_floor64(k_uptime_ticks() - start);
+	http_server_get_stats(server, &after);
+
+	for (int i = 0; i < clients; i++) {
+		if (http_load_clients[i].sock >= 0) {
+			close(http_load_clients[i].sock);
+			http_load_clients[i].sock = -1;
+		}
+	}
+
+	if (samples == 0) {
+		shell_error(sh, "No responses received");
+		return -EIO;
+	}
+
+	qsort(http_load_samples, samples, sizeof(http_load_samples[0]), http_load_cmp);
+
+	/* Each sendmsg() call carries at most one batch, about a segment */
+	responses = after.responses - before.responses;
+	sends = after.response_sends - before.response_sends;
+
+	shell_print(sh, "HTTP load GET %s, %d clients x %d requests:", path, clients, requests);
+	shell_print(sh, "  throughput:   %u req/s",
+	            (uint32_t)(samples * 1000000ULL / MAX(elapsed_us, 1)));
+	shell_print(sh, "  last byte:    avg %u us, p50 %u us, p99 %u us, max %u us",
+	            (uint32_t)(sum / samples), http_load_samples[samples / 2],
+	            http_load_samples[(samples * 99 - 1) / 100], http_load_samples[samples - 1]);
+	shell_print(sh, "  sendmsg:      %u for %u responses (%u.%02u each)", sends, responses,
+	            sends / MAX(responses, 1), sends * 100 / MAX(responses, 1) % 100);
+	shell_print(sh, "  refused:      %u", after.refused - before.refused);
+	shell_print(sh, "  errors:       %d", errors);
+	return (errors > 0) ? -EIO : 0;
+}
@@ -0,0 +1,64 @@
+/**
+ * @file http_load.h
+ * @brief HTTP server load benchmark
+ *
+ * Drives the running HTTP server with several keep-alive clients at once
+ * and reports throughput, time to the last byte and the sendmsg() calls
+ * the server made per response. Each client sends its next GET as soon
+ * as the previous response has fully arrived, whether framed by
+ * Content-Length or chunked.
+ *
+ * The clients share the socket and network context budget with the
+ * server, so their number is capped at what is left once the server
+ * holds every connection slot, and at the slots themselves: clients
+ * beyond those would only be refused.
+ */
+
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/net/net_ip.h>
+#include "http_server.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Descriptors and network contexts left for clients once the server has
+ * its listening socket, event fd and every connection. stdin, stdout and
+ * stderr take three descriptors. The DHCP server of AP mode takes one
+ * more context, which shows as a client that fails to connect.
+ */
+#define HTTP_LOAD_FREE_FDS \
+	(CONFIG_ZVFS_OPEN_MAX - 3 - 2 - HTTP_SERVER_MAX_CONNECTIONS)
+#define HTTP_LOAD_FREE_CONTEXTS \
+	(CONFIG_NET_MAX_CONTEXTS - 1 - HTTP_SERVER_MAX_CONNECTIONS)
+
+/** Most clients one run can use */
+#define HTTP_LOAD_MAX_CLIENTS \
+	MIN(HTTP_SERVER_MAX_CONNECTIONS, MIN(HTTP_LOAD_FREE_FDS, HTTP_LOAD_FREE_CONTEXTS))
+
+/** Most requests one run can time, over all clients */
+#define HTTP_LOAD_MAX_SAMPLES 512
+
+/**
+ * @brief Run the load benchmark and print its results
+ *
+ * @param sh Shell to print to
+ * @param server Running HTTP server
+ * @param addr Address the server listens on, or NULL for loopback
+ * @param clients Number of concurrent clients, 1 to HTTP_LOAD_MAX_CLIENTS
+ * @param requests Requests per client
+ * @param path Path to request
+ * @return 0 on success, -EINVAL for bad arguments, -ENODEV if the server
+ *         is not running, -EIO if any request failed
+ */
+int http_load_run(const struct shell *sh, struct http_server *server,
+                  const struct in_addr *addr, int clients, int requests,
+                  const char *path);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,471 @@
+/**
+ * @file http_parser.c
+ * @brief Incremental HTTP/1.x request parser implementation
+ */
+
+#include "http_parser.h"
+#include <string.h>
+#include <strings.h>
+
+/* Names of the headers listed in enum http_header_id, in the same order */
+static const char *const http_header_names[HTTP_HDR_COUNT] = {
+	[HTTP_HDR_CONTENT_LENGTH] = "Content-Length",
+	[HTTP_HDR_CONNECTION] = "Connection",
+	[HTTP_HDR_ACCEPT_ENCODING] = "Accept-Encoding",
+	[HTTP_HDR_IF_NONE_MATCH] = "If-None-Match",
+	[HTTP_HDR_UPGRADE] = "Upgrade",
+	[HTTP_HDR_WS_KEY] = "Sec-WebSocket-Key",
+	[HTTP_HDR_WS_VERSION] = "Sec-WebSocket-Version",
+	[HTTP_HDR_TRANSFER_ENCODING] = "Transfer-Encoding",
+};
+
+/* Longest method token accepted on the request line */
+#define HTTP_METHOD_MAX_LEN 7
+
+/**
+ * @brief Check for an RFC 9110 token character
+ */
+static bool http_is_tchar(char c)
+{
+	/* Header names are nearly all letters, digits and dashes */
+	if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+	    (c >= '0' && c <= '9') || c == '-') {
+		return true;
+	}
+
+	if (c <= 0x20 || c >= 0x7f) {
+		return false;
+	}
+
+	return strchr("\"(),/:;<=>?@[\\]{}", c) == NULL;
+}
+
+/**
+ * @brief Check for a byte allowed in a header value
+ */
+static bool http_is_value_char(char c)
+{
+	return ((unsigned char)c >= 0x20 && c != 0x7f) || c == '\t';
+}
+
+/**
+ * @brief Skip plain header value bytes
+ *
+ * @param buf Request buffer
+ * @param pos First byte to examine, below end
+ * @param end End of the bytes that may be examined
+ * @return Position of the first byte that needs a closer look, or of the
+ *         last byte before end if all are plain
+ */
+static size_t http_skip_value(const char *buf, size_t pos, size_t end)
+{
+	while (pos + 1 < end && http_is_value_char(buf[pos])) {
+		pos++;
+	}
+
+	return pos;
+}
+
+static enum http_method http_method_lookup(const char *s, size_t len)
+{
+	if (len == 3 && memcmp(s, "GET", 3) == 0) {
+		return HTTP_METHOD_GET;
+	}
+	if (len == 4 && memcmp(s, "POST", 4) == 0) {
+		return HTTP_METHOD_POST;
+	}
+	if (len == 4 && memcmp(s, "HEAD", 4) == 0) {
+		return HTTP_METHOD_HEAD;
+	}
+	if (len == 3 && memcmp(s, "PUT", 3) == 0) {
+		return HTTP_METHOD_PUT;
+	}
+
+	return HTTP_METHOD_OTHER;
+}
+
+static int http_header_lookup(const char *s, size_t len)
+{
+	for (int i = 0; i < HTTP_HDR_COUNT; i++) {
+		if (strlen(http_header_names[i]) == len &&
+		    strncasecmp(http_header_names[i], s, len) == 0) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/**
+ * @brief Record the header value that ends at the current position
+ */
+static int http_parser_end_value(struct http_parser *parser, const char *buf)
+{
+	size_t end = parser->pos;
+
+	/* Trim trailing whitespace */
+	while (end > parser->mark &&
+	       (buf[end - 1] == ' ' || buf[end - 1] == '\t')) {
+		end--;
+	}
+
+	if (parser->header < 0) {
+		return 0;
+	}
+
+	if (parser->header == HTTP_HDR_CONTENT_LENGTH) {
+		size_t value = 0;
+
+		/* Conflicting or malformed lengths allow request smuggling */
+		if (parser->headers[HTTP_HDR_CONTENT_LENGTH].len || end == parser->mark) {
+			return -EBADMSG;
+		}
+
+		for (size_t i = parser->mark; i < end; i++) {
+			if (buf[i] < '0' || buf[i] > '9') {
+				return -EBADMSG;
+			}
+			value = value * 10 + (buf[i] - '0');
+			if (value > parser->max_body) {
+				return -EMSGSIZE;
+			}
+		}
+
+		parser->content_length = value;
+	} else if (parser->header == HTTP_HDR_TRANSFER_ENCODING && end == parser->mark) {
+		/* An empty value would leave the header looking absent */
+		return -EBADMSG;
+	}
+
+	parser->headers[parser->header].off = parser->mark;
+	parser->headers[parser->header].len = end - parser->mark;
+	return 0;
+}
+
+/**
+ * @brief Start the body once the blank line ending the headers is seen
+ */
+static int http_parser_end_headers(struct http_parser *parser)
+{
+	/* Only Content-Length frames a body here; any other framing would
+	 * leave the body to be parsed as the next request on the connection
+	 */
+	if (parser->headers[HTTP_HDR_TRANSFER_ENCODING].len) {
+		return parser->headers[HTTP_HDR_CONTENT_LENGTH].len ? -EBADMSG : -ENOTSUP;
+	}
+
+	parser->body_off = parser->pos + 1;
+	parser->state = HTTP_PARSER_BODY;
+	return 0;
+}
+
+void http_parser_init(struct http_parser *parser, size_t max_header,
+                      size_t max_body)
+{
+	memset(parser, 0, sizeof(struct http_parser));
+	parser->max_header = MIN(max_header, UINT16_MAX);
+	parser->max_body = max_body;
+	parser->state = HTTP_PARSER_METHOD;
+	parser->header = -1;
+}
+
+int http_parser_execute(struct http_parser *parser, const char *buf, size_t len)
+{
+	size_t end = MIN(len, parser->max_header);
+	int ret;
+
+	while (parser->pos < len && parser->state < HTTP_PARSER_BODY) {
+		char c = buf[parser->pos];
+
+		if (parser->pos >= parser->max_header) {
+			return -EMSGSIZE;
+		}
+
+		switch (parser->state) {
+		case HTTP_PARSER_METHOD:
+			if (c == ' ') {
+				if (parser->pos == parser->mark) {
+					return -EBADMSG;
+				}
+				parser->method = http_method_lookup(buf + parser->mark,
+				                                    parser->pos - parser->mark);
+				parser->state = HTTP_PARSER_PATH;
+				parser->mark = parser->pos + 1;
+			} else if (c < 'A' || c > 'Z' ||
+			           parser->pos - parser->mark >= HTTP_METHOD_MAX_LEN) {
+				return -EBADMSG;
+			}
+			break;
+
+		case HTTP_PARSER_PATH:
+			if (c == ' ') {
+				if (parser->pos == parser->mark) {
+					return -EBADMSG;
+				}
+				parser->path.off = parser->mark;
+				parser->path.len = parser->pos - parser->mark;
+				parser->state = HTTP_PARSER_VERSION;
+				parser->mark = parser->pos + 1;
+			} else if (c <= 0x20 || c >= 0x7f) {
+				return -EBADMSG;
+			}
+			break;
+
+		case HTTP_PARSER_VERSION:
+			if (c == '\r' || c == '\n') {
+				if (parser->pos - parser->mark != 8 ||
+				    strncmp(buf + parser->mark, "HTTP/1.", 7) != 0 ||
+				    (buf[parser->mark + 7] != '0' &&
+				     buf[parser->mark + 7] != '1')) {
+					return -EBADMSG;
+				}
+				parser->http11 = (buf[parser->mark + 7] == '1');
+				parser->state = (c == '\r') ? HTTP_PARSER_REQUEST_LF :
+				                HTTP_PARSER_HEADER_START;
+			} else if (parser->pos - parser->mark >= 8) {
+				return -EBADMSG;
+			}
+			break;
+
+		case HTTP_PARSER_REQUEST_LF:
+		case HTTP_PARSER_HEADER_LF:
+			if (c != '\n') {
+				return -EBADMSG;
+			}
+			parser->state = HTTP_PARSER_HEADER_START;
+			break;
+
+		case HTTP_PARSER_HEADER_START:
+			if (c == '\r') {
+				parser->state = HTTP_PARSER_HEADERS_END_LF;
+			} else if (c == '\n') {
+				ret = http_parser_end_headers(parser);
+				if (ret) {
+					return ret;
+				}
+			} else if (http_is_tchar(c)) {
+				parser->mark = parser->pos;
+				parser->state = HTTP_PARSER_HEADER_NAME;
+			} else {
+				return -EBADMSG;
+			}
+			break;
+
+		case HTTP_PARSER_HEADER_NAME:
+			if (c == ':') {
+				parser->header = http_header_lookup(buf + parser->mark,
+				                                    parser->pos - parser->mark);
+				parser->state = HTTP_PARSER_HEADER_VALUE_WS;
+			} else if (!http_is_tchar(c)) {
+				return -EBADMSG;
+			}
+			break;
+
+		case HTTP_PARSER_HEADER_VALUE_WS:
+			if (c == ' ' || c == '\t') {
+				break;
+			}
+			/* Re-examine this byte as the first value byte */
+			parser->mark = parser->pos;
+			parser->state = HTTP_PARSER_HEADER_VALUE;
+			continue;
+
+		case HTTP_PARSER_HEADER_VALUE:
+			/* Values make up most of a request; skip their plain bytes here */
+			parser->pos = http_skip_value(buf, parser->pos, end);
+			c = buf[parser->pos];
+
+			if (c == '\r' || c == '\n') {
+				ret = http_parser_end_value(parser, buf);
+				if (ret) {
+					return ret;
+				}
+				parser->state = (c == '\r') ? HTTP_PARSER_HEADER_LF :
+				                HTTP_PARSER_HEADER_START;
+			} else if (!http_is_value_char(c)) {
+				return -EBADMSG;
+			}
+			break;
+
+		case HTTP_PARSER_HEADERS_END_LF:
+			if (c != '\n') {
+				return -EBADMSG;
+			}
+			ret = http_parser_end_headers(parser);
+			if (ret) {
+				return ret;
+			}
+			break;
+
+		default:
+			return -EBADMSG;
+		}
+
+		parser->pos++;
+	}
+
+	/* Callers size their buffer to the limit, so a full buffer still short
+	 * of the body is over it even though no byte past it was examined
+	 */
+	if (parser->state < HTTP_PARSER_BODY && len >= parser->max_header) {
+		return -EMSGSIZE;
+	}
+
+	if (parser->state == HTTP_PARSER_BODY &&
+	    len - parser->body_off >= parser->content_length) {
+		parser->pos = parser->body_off + parser->content_length;
+		parser->state = HTTP_PARSER_DONE;
+	}
+
+	return (parser->state == HTTP_PARSER_DONE) ? HTTP_PARSE_DONE :
+	       HTTP_PARSE_INCOMPLETE;
+}
+
+/**
+ * @brief Walk the comma-separated elements of a header value
+ *
+ * @param p In: start of the remaining value; out: start of the next element
+ * @param end End of the header value
+ * @param elem_len Output length of the trimmed element
+ * @return Start of the trimmed element
+ */
+static const char *http_next_element(const char **p, const char *end,
+                                     size_t *elem_len)
+{
+	const char *start = *p;
+	const char *elem_end = memchr(start, ',', end - start);
+	const char *trim;
+
+	if (!elem_end) {
+		elem_end = end;
+	}
+	*p = elem_end + 1;
+
+	while (start < elem_end && (*start == ' ' || *start == '\t')) {
+		start++;
+	}
+	trim = elem_end;
+	while (trim > start && (trim[-1] == ' ' || trim[-1] == '\t')) {
+		trim--;
+	}
+
+	*elem_len = trim - start;
+	return start;
+}
+
+bool http_parser_header_has(const struct http_parser *parser, const char *buf,
+                            enum http_header_id id, const char *token)
+{
+	const char *p = buf + parser->headers[id].off;
+	const char *end = p + parser->headers[id].len;
+	size_t token_len = strlen(token);
+
+	while (p < end) {
+		size_t len;
+		const char *elem = http_next_element(&p, end, &len);
+		const char *params = memchr(elem, ';', len);
+
+		if (params) {
+			len = params - elem;
+			while (len > 0 && (elem[len - 1] == ' ' || elem[len - 1] == '\t')) {
+				len--;
+			}
+		}
+
+		if (len == token_len && strncasecmp(elem, token, token_len) == 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool http_parser_etag_match(const struct http_parser *parser, const char *buf,
+                            const char *etag)
+{
+	const char *p = buf + parser->headers[HTTP_HDR_IF_NONE_MATCH].off;
+	const char *end = p + parser->headers[HTTP_HDR_IF_NONE_MATCH].len;
+	size_t etag_len = strlen(etag);
+
+	while (p < end) {
+		size_t len;
+		const char *elem = http_next_element(&p, end, &len);
+
+		if (len == 1 && elem[0] == '*') {
+			return true;
+		}
+
+		if (len >= 2 && elem[0] == 'W' && elem[1] == '/') {
+			elem += 2;
+			len -= 2;
+		}
+
+		if (len == etag_len && memcmp(elem, etag, len) == 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static int http_hex_value(char c)
+{
+	if (c >= '0' && c <= '9') {
+		return c - '0';
+	}
+	if (c >= 'a' && c <= 'f') {
+		return c - 'a' + 10;
+	}
+	if (c >= 'A' && c <= 'F') {
+		return c - 'A' + 10;
+	}
+	return -1;
+}
+
+int http_form_get(const char *body, size_t len, const char *key,
+                  char *out, size_t out_size)
+{
+	const char *p = body;
+	const char *end = body + len;
+	size_t key_len = strlen(key);
+
+	if (out_size == 0) {
+		return -EINVAL;
+	}
+
+	while (p < end) {
+		const char *field_end = memchr(p, '&', end - p);
+		const char *eq;
+
+		if (!field_end) {
+			field_end = end;
+		}
+
+		eq = memchr(p, '=', field_end - p);
+		if (eq && (size_t)(eq - p) == key_len && memcmp(p, key, key_len) == 0) {
+			size_t n = 0;
+
+			for (p = eq + 1; p < field_end && n < out_size - 1; p++) {
+				int hi, lo;
+
+				if (*p == '+') {
+					out[n++] = ' ';
+				} else if (*p == '%' && field_end - p >= 3 &&
+				           (hi = http_hex_value(p[1])) >= 0 &&
+				           (lo = http_hex_value(p[2])) >= 0) {
+					out[n++] = (char)((hi << 4) | lo);
+					p += 2;
+				} else {
+					out[n++] = *p;
+				}
+			}
+
+			out[n] = '\0';
+			return n;
+		}
+
+		p = field_end + 1;
+	}
+
+	return -ENOENT;
+}
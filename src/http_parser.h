@@ -0,0 +1,196 @@
+/**
+ * @file http_parser.h
+ * @brief Incremental HTTP/1.x request parser
+ *
+ * This module parses HTTP requests in place in a connection's receive
+ * buffer. Parsing is resumable: each call continues from the last byte
+ * examined, so a request split across TCP segments is never rescanned.
+ * Tokens are reported as offsets into the caller's buffer rather than
+ * copied, and oversized input is rejected as soon as it is detected.
+ */
+
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Parse result: more data is needed */
+#define HTTP_PARSE_INCOMPLETE 0
+
+/** Parse result: a complete request (headers and body) is available */
+#define HTTP_PARSE_DONE 1
+
+/**
+ * @brief Request methods recognised by the parser
+ */
+enum http_method {
+	HTTP_METHOD_OTHER,      /**< Any method not listed below */
+	HTTP_METHOD_GET,        /**< GET */
+	HTTP_METHOD_HEAD,       /**< HEAD */
+	HTTP_METHOD_POST,       /**< POST */
+	HTTP_METHOD_PUT         /**< PUT */
+};
+
+/**
+ * @brief Request headers whose values are recorded
+ *
+ * All other headers are validated and skipped.
+ */
+enum http_header_id {
+	HTTP_HDR_CONTENT_LENGTH,  /**< Content-Length */
+	HTTP_HDR_CONNECTION,      /**< Connection */
+	HTTP_HDR_ACCEPT_ENCODING, /**< Accept-Encoding */
+	HTTP_HDR_IF_NONE_MATCH,   /**< If-None-Match */
+	HTTP_HDR_UPGRADE,         /**< Upgrade */
+	HTTP_HDR_WS_KEY,          /**< Sec-WebSocket-Key */
+	HTTP_HDR_WS_VERSION,      /**< Sec-WebSocket-Version */
+	HTTP_HDR_TRANSFER_ENCODING, /**< Transfer-Encoding, only to refuse it */
+	HTTP_HDR_COUNT
+};
+
+/**
+ * @brief Location of a token within the parse buffer
+ */
+struct http_span {
+	uint16_t off;           /**< Offset from the start of the request */
+	uint16_t len;           /**< Length in bytes (0 = absent) */
+};
+
+/**
+ * @brief Parser state machine states
+ */
+enum http_parser_state {
+	HTTP_PARSER_METHOD,
+	HTTP_PARSER_PATH,
+	HTTP_PARSER_VERSION,
+	HTTP_PARSER_REQUEST_LF,
+	HTTP_PARSER_HEADER_START,
+	HTTP_PARSER_HEADER_NAME,
+	HTTP_PARSER_HEADER_VALUE_WS,
+	HTTP_PARSER_HEADER_VALUE,
+	HTTP_PARSER_HEADER_LF,
+	HTTP_PARSER_HEADERS_END_LF,
+	HTTP_PARSER_BODY,
+	HTTP_PARSER_DONE
+};
+
+/**
+ * @brief Incremental request parser context
+ *
+ * Once http_parser_execute() returns HTTP_PARSE_DONE the request fields
+ * describe the parsed request; spans are relative to the buffer passed in.
+ */
+struct http_parser {
+	/* Limits */
+	size_t max_header;      /**< Maximum request line + headers size */
+	size_t max_body;        /**< Maximum accepted Content-Length */
+
+	/* Resumable state */
+	enum http_parser_state state;
+	size_t pos;             /**< Next byte to examine */
+	size_t mark;            /**< Start of the token being scanned */
+	int header;             /**< Header being parsed, or -1 if ignored */
+
+	/* Parsed request */
+	enum http_method method;
+	struct http_span path;
+	bool http11;            /**< Request is HTTP/1.1 */
+	struct http_span headers[HTTP_HDR_COUNT];
+	size_t content_length;
+	size_t body_off;        /**< Offset of the first body byte */
+};
+
+/**
+ * @brief Initialize (or reset) a parser for a new request
+ *
+ * @param parser Pointer to parser context
+ * @param max_header Maximum size of request line plus headers
+ * @param max_body Maximum accepted request body size
+ */
+void http_parser_init(struct http_parser *parser, size_t max_header,
+                      size_t max_body);
+
+/**
+ * @brief Continue parsing a request
+ *
+ * @p buf must hold the request from its first byte; only bytes not seen by
+ * earlier calls are examined.
+ *
+ * @param parser Pointer to parser context
+ * @param buf Buffer holding the request
+ * @param len Number of valid bytes in buf
+ * Bodies are only framed by Content-Length. A request carrying
+ * Transfer-Encoding is refused once its headers are complete: its body
+ * could not be told apart from the next request on the connection.
+ *
+ * @return HTTP_PARSE_DONE when complete, HTTP_PARSE_INCOMPLETE if more data
+ *         is needed, -EBADMSG for malformed input or Transfer-Encoding
+ *         together with Content-Length, -ENOTSUP for Transfer-Encoding
+ *         alone, -EMSGSIZE if a limit is exceeded or @p len reaches
+ *         max_header before the headers end
+ */
+int http_parser_execute(struct http_parser *parser, const char *buf, size_t len);
+
+/**
+ * @brief Get the total length of a completed request
+ *
+ * Bytes beyond this length belong to the next pipelined request.
+ *
+ * @param parser Pointer to parser context
+ * @return Request length including body
+ */
+static inline size_t http_parser_request_len(const struct http_parser *parser)
+{
+	return parser->body_off + parser->content_length;
+}
+
+/**
+ * @brief Check whether a recorded header contains a token
+ *
+ * Matching is case-insensitive against comma-separated list elements,
+ * e.g. "close" in "Connection: keep-alive, close". Parameters following
+ * an element (";q=0.5") are ignored.
+ *
+ * @param parser Pointer to parser context
+ * @param buf Buffer the request was parsed from
+ * @param id Header to inspect
+ * @param token Token to look for
+ * @return true if the header is present and lists the token
+ */
+bool http_parser_header_has(const struct http_parser *parser, const char *buf,
+                            enum http_header_id id, const char *token);
+
+/**
+ * @brief Check an If-None-Match header against an entity tag
+ *
+ * Uses the weak comparison required for If-None-Match: a "W/" prefix is
+ * ignored and "*" matches any tag.
+ *
+ * @param parser Pointer to parser context
+ * @param buf Buffer the request was parsed from
+ * @param etag Quoted entity tag of the current representation
+ * @return true if the client's cached copy is current
+ */
+bool http_parser_etag_match(const struct http_parser *parser, const char *buf,
+                            const char *etag);
+
+/**
+ * @brief Extract and URL-decode a field from a form-encoded body
+ *
+ * @param body application/x-www-form-urlencoded data (not NUL-terminated)
+ * @param len Length of body
+ * @param key Field name
+ * @param out Output buffer, always NUL-terminated on success
+ * @param out_size Size of out; longer values are truncated
+ * @return Decoded length on success, -ENOENT if the field is absent
+ */
+int http_form_get(const char *body, size_t len, const char *key,
+                  char *out, size_t out_size);
+
+#ifdef __cplusplus
+}
+#endif
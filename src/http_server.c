@@ -4,7 +4,18 @@
  */
 
 #include "http_server.h"
+#include "http_parser.h"
+#include "web_assets.h"
+#include "json_writer.h"
+#include "websocket.h"
 #include <zephyr/net/socket.h>
+#include <zephyr/net/net_if.h>
+#include <zephyr/net/net_mgmt.h>
+#include <zephyr/net/wifi_mgmt.h>
+#include <zephyr/data/json.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/zvfs/eventfd.h>
+#include <zephyr/posix/fcntl.h>
 #include <zephyr/logging/log.h>
 #include <string.h>
 #include <stdio.h>
@@ -15,210 +26,2130 @@ LOG_MODULE_REGISTER(http_server, LOG_LEVEL_INF);
 #define HTTP_SERVER_STACK_SIZE 4096
 #define HTTP_SERVER_PRIORITY 5
 
+/* Upper bound on how long the loop sleeps before re-checking `running` */
+#define HTTP_SERVER_POLL_TIMEOUT_MS 250
+
+/* Longest http_server_stop() waits for the thread; a stop is normally
+ * noticed at once through wake_fd, otherwise within one poll interval
+ */
+#define HTTP_SERVER_STOP_TIMEOUT_MS (4 * HTTP_SERVER_POLL_TIMEOUT_MS)
+
+/* Interval of keep-alive comments on /events streams */
+#define HTTP_SERVER_SSE_PING_MS 15000
+
+/* Largest formatted event-stream message */
+#define HTTP_SERVER_SSE_MSG_MAX 192
+
+/* Room reserved in tx_buf for a chunk-size line ("5b4\r\n") */
+#define HTTP_SERVER_CHUNK_LINE_MAX 8
+
+/* Idle time after which a persistent connection is closed */
+#define HTTP_SERVER_KEEPALIVE_TIMEOUT_MS CONFIG_SLIDER_HTTP_KEEPALIVE_TIMEOUT_MS
+
+/* Time allowed to receive a whole request, from its first byte */
+#define HTTP_SERVER_REQUEST_TIMEOUT_MS CONFIG_SLIDER_HTTP_REQUEST_TIMEOUT_MS
+
+/* Time a client may leave pending output unread */
+#define HTTP_SERVER_SEND_TIMEOUT_MS CONFIG_SLIDER_HTTP_SEND_TIMEOUT_MS
+
 K_THREAD_STACK_DEFINE(http_server_stack, HTTP_SERVER_STACK_SIZE);
 
-/* HTML template for configuration page */
-static const char html_header[] =
-	"HTTP/1.1 200 OK\r\n"
-	"Content-Type: text/html\r\n"
-	"Connection: close\r\n\r\n";
+/* HTML template for configuration page */
+static const char html_page_start[] =
+	"<!DOCTYPE html><html><head>"
+	"<meta name='viewport' content='width=device-width,initial-scale=1'>"
+	"<title>WiFi Setup</title>"
+	"<link rel='stylesheet' href='/style.css'>"
+	"</head><body>"
+	"<div class='container'>"
+	"<h1>WiFi Configuration</h1>"
+	"<p id='live'></p>"
+	"<p>Select a network or enter credentials manually:</p>";
+
+static const char html_form[] =
+	"<form method='POST' action='/connect'>"
+	"<label>SSID:</label><input type='text' id='ssid' name='ssid' required>"
+	"<label>Password:</label><input type='password' name='password'>"
+	"<button type='submit'>Connect</button>"
+	"</form>";
+
+static const char html_page_end[] =
+	"</div>"
+	"<script src='/app.js'></script>"
+	"</body></html>";
+
+/**
+ * @brief Parse HTTP POST data for credentials
+ *
+ * @param data POST data (form-encoded, not NUL-terminated)
+ * @param len Length of POST data
+ * @param ssid Output buffer for SSID (33 bytes)
+ * @param password Output buffer for password (65 bytes)
+ * @return 0 on success, -1 on failure
+ */
+static int parse_post_data(const char *data, size_t len, char *ssid, char *password)
+{
+	if (http_form_get(data, len, "ssid", ssid, 33) <= 0) {
+		return -1;
+	}
+
+	if (http_form_get(data, len, "password", password, 65) < 0) {
+		password[0] = '\0';
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Get the reason phrase for a status code
+ */
+static const char *http_status_reason(uint16_t status)
+{
+	switch (status) {
+	case 101:
+		return "Switching Protocols";
+	case 200:
+		return "OK";
+	case 202:
+		return "Accepted";
+	case 304:
+		return "Not Modified";
+	case 400:
+		return "Bad Request";
+	case 404:
+		return "Not Found";
+	case 405:
+		return "Method Not Allowed";
+	case 406:
+		return "Not Acceptable";
+	case 408:
+		return "Request Timeout";
+	case 413:
+		return "Content Too Large";
+	case 426:
+		return "Upgrade Required";
+	case 431:
+		return "Request Header Fields Too Large";
+	case 501:
+		return "Not Implemented";
+	case 503:
+		return "Service Unavailable";
+	default:
+		return "Internal Server Error";
+	}
+}
+
+/**
+ * @brief Release a connection slot
+ *
+ * @param conn Client connection
+ */
+static void http_conn_close(struct http_conn *conn)
+{
+	if (conn->sock >= 0) {
+		close(conn->sock);
+	}
+
+	conn->sock = -1;
+	conn->state = HTTP_CONN_FREE;
+	conn->resp = HTTP_RESP_NONE;
+	conn->creds_reply = false;
+}
+
+/**
+ * @brief Prepare the parser for the next request on a connection
+ *
+ * @param conn Client connection
+ */
+static void http_conn_reset_parser(struct http_conn *conn)
+{
+	http_parser_init(&conn->parser, sizeof(conn->rx_buf), HTTP_SERVER_MAX_BODY);
+}
+
+/**
+ * @brief Copy a string into a buffer with HTML special characters escaped
+ *
+ * @param out Output buffer, always NUL-terminated
+ * @param size Size of out
+ * @param in NUL-terminated input
+ */
+static void http_html_escape(char *out, size_t size, const char *in)
+{
+	size_t n = 0;
+
+	for (; *in && n < size - 1; in++) {
+		const char *ent;
+
+		switch (*in) {
+		case '&':
+			ent = "&amp;";
+			break;
+		case '<':
+			ent = "&lt;";
+			break;
+		case '>':
+			ent = "&gt;";
+			break;
+		case '"':
+			ent = "&quot;";
+			break;
+		case '\'':
+			ent = "&#39;";
+			break;
+		default:
+			out[n++] = *in;
+			continue;
+		}
+
+		if (n + strlen(ent) >= size) {
+			break;
+		}
+		memcpy(out + n, ent, strlen(ent));
+		n += strlen(ent);
+	}
+
+	out[n] = '\0';
+}
+
+/**
+ * @brief Bring the cached network list up to date with the scanner
+ *
+ * The list is rendered once per scanner generation and then sent by
+ * reference. While another connection is still sending the current copy
+ * it is left untouched, so the body a client receives always matches
+ * the Content-Length it was given; the next response picks up the change.
+ *
+ * @param server HTTP server context
+ */
+static void http_server_refresh_scan_cache(struct http_server *server)
+{
+	const struct wifi_scan_snapshot *snap;
+	size_t len;
+
+	if (!server->scanner) {
+		return;
+	}
+
+	if (server->scan_html_valid &&
+	    server->scan_html_gen == wifi_scanner_get_generation(server->scanner)) {
+		return;
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(server->conns); i++) {
+		if (server->conns[i].state == HTTP_CONN_WRITING &&
+		    server->conns[i].resp == HTTP_RESP_CONFIG_PAGE) {
+			return;
+		}
+	}
+
+	/* Rendered from one snapshot, even if a scan completes meanwhile */
+	snap = wifi_scanner_snapshot_get(server->scanner);
+	if (snap->count == 0) {
+		server->scan_html_len = 0;
+		server->scan_html_gen = snap->generation;
+		server->scan_html_valid = true;
+		wifi_scanner_snapshot_put(snap);
+		return;
+	}
+
+	len = snprintf(server->scan_html, sizeof(server->scan_html),
+	               "<h2>Available Networks:</h2>");
+
+	for (size_t i = 0; i < snap->count; i++) {
+		const struct wifi_scan_entry *r = &snap->entries[i];
+		char ssid[WIFI_SSID_MAX_LEN * 6 + 1];
+		int ret;
+
+		http_html_escape(ssid, sizeof(ssid), wifi_scanner_entry_ssid(snap, i));
+		ret = snprintf(server->scan_html + len, sizeof(server->scan_html) - len,
+		               "<div class='network' data-ssid='%s' "
+		               "onclick='selectNetwork(this.dataset.ssid)'>"
+		               "%s <span class='signal'>Signal: %d dBm</span><br>"
+		               "<span class='security'>%s</span></div>",
+		               ssid, ssid, r->rssi,
+		               wifi_scanner_security_to_string(r->security));
+		if (ret < 0 || (size_t)ret >= sizeof(server->scan_html) - len) {
+			LOG_WRN("Scan cache full, listing %zu of %zu networks", i, snap->count);
+			break;
+		}
+		len += ret;
+	}
+
+	server->scan_html_len = len;
+	server->scan_html_gen = snap->generation;
+	server->scan_html_valid = true;
+	LOG_DBG("Rendered %zu networks (%zu bytes, generation %u)",
+	        snap->count, len, snap->generation);
+
+	wifi_scanner_snapshot_put(snap);
+}
+
+/**
+ * @brief Get the API name of a scanner state
+ */
+static const char *http_api_scan_state(enum wifi_scanner_state state)
+{
+	switch (state) {
+	case WIFI_SCANNER_SCANNING:
+		return "scanning";
+	case WIFI_SCANNER_COMPLETE:
+		return "complete";
+	case WIFI_SCANNER_FAILED:
+		return "failed";
+	default:
+		return "idle";
+	}
+}
+
+/**
+ * @brief Check whether a response kind belongs to the JSON API
+ */
+static bool http_resp_is_api(enum http_resp_kind resp)
+{
+	return resp >= HTTP_RESP_API_STATUS;
+}
+
+/**
+ * @brief Encode one fragment of the /api/v1/status document
+ *
+ * The document is split in three, the server, Wi-Fi and scan sections,
+ * so that an SSID escaped at full length still leaves each fragment well
+ * within the scratch buffer.
+ *
+ * @param server HTTP server context
+ * @param stage Fragment to encode, 0 to 2
+ * @param w JSON writer, continuing the document after stage 0
+ */
+static void http_api_status(struct http_server *server, int stage,
+                            struct json_writer *w)
+{
+	struct net_if *iface = net_if_get_default();
+	struct wifi_iface_status status = {0};
+	int active = 0;
+
+	switch (stage) {
+	case 0:
+		for (size_t i = 0; i < ARRAY_SIZE(server->conns); i++) {
+			if (server->conns[i].state != HTTP_CONN_FREE) {
+				active++;
+			}
+		}
+
+		json_writer_object_start(w, NULL);
+		json_writer_int(w, "uptime_ms", k_uptime_get());
+		json_writer_int(w, "http_connections", active);
+
+		json_writer_object_start(w, "http_evictions");
+		json_writer_int(w, "idle", server->stats.idle_closed);
+		json_writer_int(w, "idle_for_slot", server->stats.idle_evicted);
+		json_writer_int(w, "request_timeout", server->stats.request_timeouts);
+		json_writer_int(w, "send_timeout", server->stats.send_timeouts);
+		json_writer_int(w, "oversize", server->stats.oversize);
+		json_writer_int(w, "refused", server->stats.refused);
+		json_writer_object_end(w);
+		break;
+
+	case 1:
+		if (iface && net_mgmt(NET_REQUEST_WIFI_IFACE_STATUS, iface, &status,
+		                      sizeof(status)) == 0) {
+			json_writer_object_start(w, "wifi");
+			json_writer_string(w, "state", wifi_state_txt(status.state));
+			if (status.state >= WIFI_STATE_ASSOCIATED) {
+				json_writer_string(w, "ssid", status.ssid);
+				json_writer_int(w, "channel", status.channel);
+				json_writer_int(w, "rssi", status.rssi);
+				json_writer_string(w, "security",
+				                   wifi_scanner_security_to_string(status.security));
+			}
+			json_writer_object_end(w);
+		} else {
+			json_writer_null(w, "wifi");
+		}
+		break;
+
+	default:
+		if (server->scanner) {
+			const struct wifi_scan_snapshot *snap =
+				wifi_scanner_snapshot_get(server->scanner);
+
+			json_writer_object_start(w, "scan");
+			json_writer_string(w, "state",
+			                   http_api_scan_state(wifi_scanner_get_state(server->scanner)));
+			json_writer_int(w, "generation", snap->generation);
+			json_writer_int(w, "networks", snap->count);
+			json_writer_object_end(w);
+			wifi_scanner_snapshot_put(snap);
+		}
+
+		json_writer_object_end(w);
+		break;
+	}
+}
+
+/**
+ * @brief Produce the next fragment of a JSON API response
+ *
+ * Each fragment is encoded into the caller's buffer. Lists are emitted one
+ * element per fragment, so the document is never held in memory at once.
+ *
+ * @param server HTTP server context
+ * @param conn Connection whose response is generated
+ * @param stage Cursor stage, 0 on the first call
+ * @param index Cursor index within the stage, 0 on the first call
+ * @param buf Output buffer
+ * @param size Size of buf
+ * @param data Output pointer to the fragment
+ * @return Fragment length (untruncated), or 0 when the body is complete
+ */
+static size_t http_api_fragment(struct http_server *server,
+                                struct http_conn *conn,
+                                int *stage, size_t *index,
+                                char *buf, size_t size,
+                                const char **data)
+{
+	struct json_writer w;
+
+	json_writer_init(&w, buf, size, false);
+	*data = buf;
+
+	switch (conn->resp) {
+	case HTTP_RESP_API_STATUS:
+		if (*stage > 2) {
+			return 0;
+		}
+		json_writer_init(&w, buf, size, *stage > 0);
+		http_api_status(server, (*stage)++, &w);
+		break;
+
+	case HTTP_RESP_API_SCAN: {
+		const struct wifi_scan_snapshot *snap = NULL;
+
+		switch (*stage) {
+		case 0:
+			json_writer_object_start(&w, NULL);
+			json_writer_string(&w, "state",
+			                   http_api_scan_state(server->scanner ?
+			                   wifi_scanner_get_state(server->scanner) :
+			                   WIFI_SCANNER_IDLE));
+			json_writer_int(&w, "generation", conn->api_gen);
+			if (server->scanner) {
+				snap = wifi_scanner_snapshot_get(server->scanner);
+			}
+			if (snap && snap->timestamp != 0) {
+				json_writer_int(&w, "age_ms", wifi_scanner_snapshot_age_ms(snap));
+			} else {
+				json_writer_null(&w, "age_ms");
+			}
+			wifi_scanner_snapshot_put(snap);
+			json_writer_array_start(&w, "networks");
+			(*stage)++;
+			break;
+		case 1:
+			/* Pinned for one entry at a time; the response may span
+			 * many writes and must not hold up the next scan
+			 */
+			if (server->scanner) {
+				snap = wifi_scanner_snapshot_get(server->scanner);
+			}
+
+			/* Stop listing if a new scan replaced the results mid-stream */
+			if (!snap || *index >= snap->count || snap->generation != conn->api_gen) {
+				wifi_scanner_snapshot_put(snap);
+				(*stage)++;
+				return http_api_fragment(server, conn, stage, index,
+				                         buf, size, data);
+			}
+
+			const struct wifi_scan_entry *r = &snap->entries[*index];
+			char bssid[18];
+
+			snprintf(bssid, sizeof(bssid), "%02x:%02x:%02x:%02x:%02x:%02x",
+			         r->bssid[0], r->bssid[1], r->bssid[2],
+			         r->bssid[3], r->bssid[4], r->bssid[5]);
+
+			json_writer_init(&w, buf, size, *index > 0);
+			json_writer_object_start(&w, NULL);
+			json_writer_string(&w, "ssid", wifi_scanner_entry_ssid(snap, *index));
+			json_writer_string(&w, "bssid", bssid);
+			json_writer_int(&w, "rssi", r->rssi);
+			json_writer_int(&w, "channel", r->channel);
+			json_writer_string(&w, "security",
+			                   wifi_scanner_security_to_string(r->security));
+			json_writer_int(&w, "age_s", wifi_scanner_entry_age_s(snap, *index));
+			json_writer_object_end(&w);
+			wifi_scanner_snapshot_put(snap);
+			(*index)++;
+			break;
+		case 2:
+			json_writer_array_end(&w);
+			json_writer_object_end(&w);
+			(*stage)++;
+			break;
+		default:
+			return 0;
+		}
+		break;
+	}
+
+	case HTTP_RESP_API_SETTINGS: {
+		struct http_server_settings settings = {0};
+
+		if ((*stage)++ > 0) {
+			return 0;
+		}
+		if (server->settings_cb) {
+			server->settings_cb(&settings, server->cb_user_data);
+		}
+		json_writer_object_start(&w, NULL);
+		json_writer_bool(&w, "configured", settings.ssid[0] != '\0');
+		json_writer_string(&w, "ssid", settings.ssid);
+		json_writer_object_end(&w);
+		break;
+	}
+
+	case HTTP_RESP_API_ACCEPTED:
+		if ((*stage)++ > 0) {
+			return 0;
+		}
+		json_writer_object_start(&w, NULL);
+		json_writer_string(&w, "result", "accepted");
+		json_writer_string(&w, "ssid", server->creds_ssid);
+		json_writer_object_end(&w);
+		break;
+
+	case HTTP_RESP_API_JSON:
+		/* Skip fragments that came out empty; a zero length ends the body */
+		while (conn->json_render(&w, (*index)++)) {
+			if (json_writer_len(&w) > 0) {
+				return json_writer_len(&w);
+			}
+			json_writer_init(&w, buf, size, false);
+		}
+		return 0;
+
+	case HTTP_RESP_API_ERROR:
+		if ((*stage)++ > 0) {
+			return 0;
+		}
+		json_writer_object_start(&w, NULL);
+		json_writer_int(&w, "status", conn->status);
+		json_writer_string(&w, "error", http_status_reason(conn->status));
+		json_writer_object_end(&w);
+		break;
+
+	default:
+		return 0;
+	}
+
+	return json_writer_len(&w);
+}
+
+/**
+ * @brief Produce the next fragment of a response body
+ *
+ * Static fragments are returned straight from flash and the network list
+ * from the server's render cache. Fragments rendered per request go into
+ * the caller's buffer. The same walk is used to size the body for
+ * Content-Length and to send it.
+ *
+ * @param server HTTP server context
+ * @param conn Connection whose response is generated
+ * @param stage Cursor stage, 0 on the first call
+ * @param index Cursor index within the stage, 0 on the first call
+ * @param buf Scratch buffer for rendered fragments
+ * @param size Size of buf
+ * @param data Output pointer to the fragment
+ * @return Fragment length, or 0 when the body is complete. A rendered
+ *         fragment that did not fit reports its untruncated length
+ *         (>= size), like snprintf().
+ */
+static size_t http_body_fragment(struct http_server *server,
+                                 struct http_conn *conn,
+                                 int *stage, size_t *index,
+                                 char *buf, size_t size,
+                                 const char **data)
+{
+	switch (conn->resp) {
+	case HTTP_RESP_ASSET:
+		/* 304 responses carry no body */
+		if ((*stage)++ > 0 || conn->status != 200) {
+			return 0;
+		}
+		*data = (const char *)conn->asset->data;
+		return conn->asset->len;
+	case HTTP_RESP_ERROR:
+		/* The reason phrase doubles as a plain-text body */
+		if ((*stage)++ > 0) {
+			return 0;
+		}
+		*data = http_status_reason(conn->status);
+		return strlen(*data);
+	case HTTP_RESP_WS_UPGRADE:
+		return 0;
+	case HTTP_RESP_EVENTS:
+		/* The stream itself starts once the header is out */
+		if ((*stage)++ > 0) {
+			return 0;
+		}
+		*data = "retry: 5000\n\n";
+		return strlen(*data);
+	case HTTP_RESP_CONFIG_PAGE:
+		break;
+	default:
+		return http_api_fragment(server, conn, stage, index, buf, size, data);
+	}
+
+	switch (*stage) {
+	case 0:
+		*data = html_page_start;
+		break;
+	case 1:
+		if (server->scan_html_len == 0) {
+			*stage = 2;
+			return http_body_fragment(server, conn, stage, index,
+			                          buf, size, data);
+		}
+		*data = server->scan_html;
+		(*stage)++;
+		return server->scan_html_len;
+	case 2:
+		*data = "<h2>Enter Credentials:</h2>";
+		break;
+	case 3:
+		*data = html_form;
+		break;
+	case 4:
+		*data = html_page_end;
+		break;
+	default:
+		return 0;
+	}
+
+	(*stage)++;
+	return strlen(*data);
+}
+
+/**
+ * @brief Assemble the next batch of response fragments
+ *
+ * Static fragments are referenced in place; rendered fragments are packed
+ * into tx_buf. A batch stops at about one TCP segment, when the iovec
+ * array is full, or when the next rendered fragment would not fit, so
+ * each sendmsg() call fills a segment instead of emitting many tiny ones.
+ * For chunked responses each batch is framed as one chunk, and the
+ * zero-length last chunk is queued once the body is exhausted.
+ *
+ * A rendered fragment larger than all of tx_buf fails the response: the
+ * body stops before it, without the last chunk, and the connection closes.
+ *
+ * @param server HTTP server context
+ * @param conn Client connection
+ */
+static void http_conn_fill_batch(struct http_server *server,
+                                 struct http_conn *conn)
+{
+	size_t batch = 0;
+	size_t body = 0;
+	size_t scratch_floor = 0;
+	int iov_max = HTTP_SERVER_TX_IOV_MAX;
+	int size_iov = -1;
+	bool done = false;
+
+	if (conn->tx_failed || conn->tx_head) {
+		return;
+	}
+
+	for (int i = 0; i < conn->tx_iov_cnt; i++) {
+		batch += conn->tx_iov[i].iov_len;
+	}
+
+	if (conn->tx_chunked) {
+		if (conn->tx_chunk_end) {
+			return;
+		}
+
+		/* Reserve the chunk-size line, written once the batch is known */
+		size_iov = conn->tx_iov_cnt++;
+		conn->tx_iov[size_iov].iov_base = conn->tx_buf + conn->tx_scratch_len;
+		conn->tx_scratch_len += HTTP_SERVER_CHUNK_LINE_MAX;
+		scratch_floor = HTTP_SERVER_CHUNK_LINE_MAX;
+		/* Keep a slot for the CRLF that ends the chunk */
+		iov_max--;
+	}
+
+	while (conn->tx_iov_cnt < iov_max &&
+	       batch < HTTP_SERVER_TX_BATCH_SIZE &&
+	       conn->tx_scratch_len < sizeof(conn->tx_buf)) {
+		int stage = conn->resp_stage;
+		size_t index = conn->resp_index;
+		char *buf = conn->tx_buf + conn->tx_scratch_len;
+		size_t avail = sizeof(conn->tx_buf) - conn->tx_scratch_len;
+		const char *data;
+		size_t len;
+
+		len = http_body_fragment(server, conn, &conn->resp_stage,
+		                         &conn->resp_index, buf, avail, &data);
+		if (len == 0) {
+			done = true;
+			break;
+		}
+
+		if (data == buf) {
+			if (len >= avail) {
+				if (conn->tx_scratch_len > scratch_floor) {
+					/* Render it again at the start of the next batch */
+					conn->resp_stage = stage;
+					conn->resp_index = index;
+					break;
+				}
+
+				/* Sending it cut short would pass for a valid body;
+				 * end the response unfinished so the client sees it failed
+				 */
+				LOG_ERR("Response fragment of %zu bytes exceeds %zu byte buffer",
+				        len, avail - 1);
+				conn->tx_failed = true;
+				conn->keep_alive = false;
+				break;
+			}
+			conn->tx_scratch_len += len;
+		}
+
+		conn->tx_iov[conn->tx_iov_cnt].iov_base = (void *)data;
+		conn->tx_iov[conn->tx_iov_cnt].iov_len = len;
+		conn->tx_iov_cnt++;
+		batch += len;
+		body += len;
+	}
+
+	if (size_iov < 0) {
+		return;
+	}
+
+	if (body > 0) {
+		conn->tx_iov[size_iov].iov_len =
+			snprintf(conn->tx_iov[size_iov].iov_base,
+			         HTTP_SERVER_CHUNK_LINE_MAX, "%zx\r\n", body);
+		/* Small bodies end in the same batch as their only chunk */
+		if (done) {
+			conn->tx_iov[conn->tx_iov_cnt].iov_base = (void *)"\r\n0\r\n\r\n";
+			conn->tx_iov[conn->tx_iov_cnt].iov_len = 7;
+			conn->tx_chunk_end = true;
+		} else {
+			conn->tx_iov[conn->tx_iov_cnt].iov_base = (void *)"\r\n";
+			conn->tx_iov[conn->tx_iov_cnt].iov_len = 2;
+		}
+		conn->tx_iov_cnt++;
+	} else if (done) {
+		conn->tx_iov[size_iov].iov_base = (void *)"0\r\n\r\n";
+		conn->tx_iov[size_iov].iov_len = 5;
+		conn->tx_chunk_end = true;
+	} else {
+		/* Nothing fitted beside the header; the chunk starts next batch */
+		conn->tx_iov_cnt--;
+		conn->tx_scratch_len -= HTTP_SERVER_CHUNK_LINE_MAX;
+	}
+}
+
+/**
+ * @brief Count connections upgraded to WebSocket
+ *
+ * @param server HTTP server context
+ * @return Number of WebSocket clients
+ */
+static int http_server_ws_count(struct http_server *server)
+{
+	int count = 0;
+
+	for (size_t i = 0; i < ARRAY_SIZE(server->conns); i++) {
+		if (server->conns[i].state == HTTP_CONN_WEBSOCKET) {
+			count++;
+		}
+	}
+
+	return count;
+}
+
+/**
+ * @brief Queue a frame on a WebSocket connection
+ *
+ * @param conn WebSocket connection
+ * @param opcode Frame opcode
+ * @param payload Frame payload
+ * @param len Payload length
+ * @return 0 on success, -ENOBUFS if the send queue cannot take the frame
+ */
+static int http_ws_queue(struct http_conn *conn, enum ws_opcode opcode,
+                         const uint8_t *payload, size_t len)
+{
+	uint8_t hdr[WS_FRAME_HEADER_MAX];
+	size_t hdr_len = ws_frame_header(hdr, opcode, len);
+
+	if (conn->tx_queue_len + hdr_len + len > sizeof(conn->tx_buf)) {
+		return -ENOBUFS;
+	}
+
+	if (conn->tx_queue_len == 0) {
+		conn->last_tx = k_uptime_get();
+	}
+
+	memcpy(conn->tx_buf + conn->tx_queue_len, hdr, hdr_len);
+	memcpy(conn->tx_buf + conn->tx_queue_len + hdr_len, payload, len);
+	conn->tx_queue_len += hdr_len + len;
+	return 0;
+}
+
+/**
+ * @brief Send queued stream data without blocking
+ *
+ * Used by WebSocket and event stream connections. When close_after_flush
+ * is set the connection is dropped once the queue drains.
+ *
+ * @param conn Streaming connection
+ */
+static void http_conn_flush_queue(struct http_conn *conn)
+{
+	while (conn->tx_queue_len > 0) {
+		ssize_t ret = send(conn->sock, conn->tx_buf, conn->tx_queue_len, 0);
+
+		if (ret < 0) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				/* Resume when poll() reports POLLOUT */
+				return;
+			}
+			LOG_DBG("Stream send failed: %d", errno);
+			http_conn_close(conn);
+			return;
+		}
+
+		conn->tx_queue_len -= ret;
+		memmove(conn->tx_buf, conn->tx_buf + ret, conn->tx_queue_len);
+		conn->last_activity = k_uptime_get();
+		conn->last_tx = conn->last_activity;
+	}
+
+	if (conn->close_after_flush) {
+		http_conn_close(conn);
+	}
+}
+
+/**
+ * @brief Start the closing handshake with a status code
+ *
+ * @param conn WebSocket connection
+ * @param code Close status code
+ */
+static void http_ws_close(struct http_conn *conn, uint16_t code)
+{
+	uint8_t payload[2];
+
+	sys_put_be16(code, payload);
+	(void)http_ws_queue(conn, WS_OP_CLOSE, payload, sizeof(payload));
+	conn->close_after_flush = true;
+}
+
+/**
+ * @brief Handle one binary message from a WebSocket client
+ *
+ * @param server HTTP server context
+ * @param msg Message payload
+ * @param len Payload length
+ */
+static void http_ws_message(struct http_server *server,
+                            const uint8_t *msg, size_t len)
+{
+	struct http_server_jog jog = {0};
+
+	if (len == 0) {
+		return;
+	}
+
+	switch (msg[0]) {
+	case HTTP_WS_MSG_JOG:
+		if (len < 5) {
+			LOG_DBG("Short jog command (%zu bytes)", len);
+			return;
+		}
+		jog.velocity = (int16_t)sys_get_le16(msg + 1);
+		jog.duration_ms = sys_get_le16(msg + 3);
+		break;
+	case HTTP_WS_MSG_STOP:
+		break;
+	default:
+		LOG_DBG("Unknown WebSocket message type 0x%02x", msg[0]);
+		return;
+	}
+
+	if (server->jog_cb) {
+		server->jog_cb(&jog, server->cb_user_data);
+	}
+}
+
+/**
+ * @brief Handle every complete frame buffered on a WebSocket connection
+ *
+ * @param server HTTP server context
+ * @param conn WebSocket connection
+ */
+static void http_ws_process(struct http_server *server, struct http_conn *conn)
+{
+	size_t off = 0;
+
+	while (!conn->close_after_flush) {
+		struct ws_frame frame;
+		int ret;
+
+		ret = ws_frame_decode((uint8_t *)conn->rx_buf + off, conn->rx_len - off,
+		                      sizeof(conn->rx_buf), &frame);
+		if (ret == 0) {
+			break;
+		}
+		if (ret < 0) {
+			http_ws_close(conn, (ret == -EMSGSIZE) ? WS_CLOSE_TOO_BIG :
+			              WS_CLOSE_PROTOCOL_ERROR);
+			break;
+		}
+		off += frame.frame_len;
+
+		switch (frame.opcode) {
+		case WS_OP_BINARY:
+			if (!frame.fin) {
+				/* Commands are tiny; fragmented messages are not used */
+				http_ws_close(conn, WS_CLOSE_UNSUPPORTED);
+				break;
+			}
+			http_ws_message(server, frame.payload, frame.payload_len);
+			break;
+		case WS_OP_PING:
+			(void)http_ws_queue(conn, WS_OP_PONG, frame.payload,
+			                    frame.payload_len);
+			break;
+		case WS_OP_PONG:
+			break;
+		case WS_OP_CLOSE:
+			/* Echo the client's status code to complete the handshake */
+			(void)http_ws_queue(conn, WS_OP_CLOSE, frame.payload,
+			                    MIN(frame.payload_len, 2));
+			conn->close_after_flush = true;
+			break;
+		case WS_OP_TEXT:
+		case WS_OP_CONTINUATION:
+			http_ws_close(conn, WS_CLOSE_UNSUPPORTED);
+			break;
+		default:
+			http_ws_close(conn, WS_CLOSE_PROTOCOL_ERROR);
+			break;
+		}
+	}
+
+	conn->rx_len -= off;
+	memmove(conn->rx_buf, conn->rx_buf + off, conn->rx_len);
+
+	http_conn_flush_queue(conn);
+}
+
+/**
+ * @brief Push the device state frame to every WebSocket client when due
+ *
+ * A client whose send queue is still full from the last push simply
+ * misses this sample; the next one supersedes it.
+ *
+ * @param server HTTP server context
+ */
+static void http_server_ws_push(struct http_server *server)
+{
+	struct http_server_telemetry telemetry = {0};
+	struct wifi_iface_status status = {0};
+	struct net_if *iface;
+	int64_t now = k_uptime_get();
+	int clients = http_server_ws_count(server);
+	uint8_t msg[12];
+
+	if (clients == 0 || now < server->ws_next_push) {
+		return;
+	}
+	server->ws_next_push = now + HTTP_SERVER_WS_TELEMETRY_MS;
+
+	iface = net_if_get_default();
+	if (!iface || net_mgmt(NET_REQUEST_WIFI_IFACE_STATUS, iface, &status,
+	                       sizeof(status))) {
+		status.state = WIFI_STATE_DISCONNECTED;
+		status.rssi = 0;
+	}
+
+	if (server->telemetry_cb) {
+		server->telemetry_cb(&telemetry, server->cb_user_data);
+	}
+
+	msg[0] = HTTP_WS_MSG_STATE;
+	msg[1] = status.state;
+	msg[2] = (int8_t)status.rssi;
+	msg[3] = clients;
+	sys_put_le32(telemetry.position, &msg[4]);
+	sys_put_le32((uint32_t)now, &msg[8]);
+
+	for (size_t i = 0; i < ARRAY_SIZE(server->conns); i++) {
+		struct http_conn *conn = &server->conns[i];
+
+		if (conn->state == HTTP_CONN_WEBSOCKET && !conn->close_after_flush &&
+		    http_ws_queue(conn, WS_OP_BINARY, msg, sizeof(msg)) == 0) {
+			http_conn_flush_queue(conn);
+		}
+	}
+}
+
+/**
+ * @brief Count connections subscribed to /events
+ *
+ * @param server HTTP server context
+ * @return Number of subscribers
+ */
+static int http_server_sse_count(struct http_server *server)
+{
+	int count = 0;
+
+	for (size_t i = 0; i < ARRAY_SIZE(server->conns); i++) {
+		if (server->conns[i].state == HTTP_CONN_EVENTS) {
+			count++;
+		}
+	}
+
+	return count;
+}
+
+/**
+ * @brief Append bytes to a connection's send queue
+ *
+ * @param conn Streaming connection
+ * @param data Bytes to queue
+ * @param len Number of bytes
+ * @return 0 on success, -ENOBUFS if they do not fit
+ */
+static int http_conn_enqueue(struct http_conn *conn, const char *data, size_t len)
+{
+	if (conn->tx_queue_len + len > sizeof(conn->tx_buf)) {
+		return -ENOBUFS;
+	}
+
+	if (conn->tx_queue_len == 0) {
+		conn->last_tx = k_uptime_get();
+	}
+
+	memcpy(conn->tx_buf + conn->tx_queue_len, data, len);
+	conn->tx_queue_len += len;
+	return 0;
+}
+
+/**
+ * @brief Format an event as a text/event-stream message
+ *
+ * @param event Event to format
+ * @param buf Output buffer
+ * @param size Size of buf
+ * @return Message length; >= size if it did not fit
+ */
+static size_t http_sse_format(const struct http_event *event, char *buf, size_t size)
+{
+	static const char *const wifi_states[] = {
+		[HTTP_EVENT_WIFI_CONNECTING] = "connecting",
+		[HTTP_EVENT_WIFI_CONNECTED] = "connected",
+		[HTTP_EVENT_WIFI_FAILED] = "failed",
+		[HTTP_EVENT_WIFI_DISCONNECTED] = "disconnected",
+	};
+	struct json_writer w;
+	const char *name;
+	int len;
+
+	switch (event->type) {
+	case HTTP_EVENT_SCAN_STARTED:
+		name = "scan_started";
+		break;
+	case HTTP_EVENT_SCAN_RESULT:
+		name = "scan_result";
+		break;
+	case HTTP_EVENT_SCAN_DONE:
+		name = "scan_done";
+		break;
+	default:
+		name = "wifi";
+		break;
+	}
+
+	len = snprintf(buf, size, "event: %s\ndata: ", name);
+	if (len < 0 || (size_t)len >= size) {
+		return size;
+	}
+
+	json_writer_init(&w, buf + len, size - len, false);
+	json_writer_object_start(&w, NULL);
+
+	switch (event->type) {
+	case HTTP_EVENT_SCAN_STARTED:
+		break;
+	case HTTP_EVENT_SCAN_RESULT:
+		json_writer_string(&w, "ssid", event->ssid);
+		json_writer_int(&w, "rssi", event->rssi);
+		json_writer_int(&w, "channel", event->channel);
+		json_writer_string(&w, "security",
+		                   wifi_scanner_security_to_string(event->security));
+		break;
+	case HTTP_EVENT_SCAN_DONE:
+		json_writer_int(&w, "status", event->status);
+		break;
+	case HTTP_EVENT_WIFI_CONNECTING:
+	case HTTP_EVENT_WIFI_CONNECTED:
+	case HTTP_EVENT_WIFI_FAILED:
+	case HTTP_EVENT_WIFI_DISCONNECTED:
+		json_writer_string(&w, "state", wifi_states[event->type]);
+		if (event->ssid[0]) {
+			json_writer_string(&w, "ssid", event->ssid);
+		}
+		if (event->type == HTTP_EVENT_WIFI_FAILED) {
+			json_writer_int(&w, "status", event->status);
+		}
+		break;
+	default:
+		break;
+	}
+
+	json_writer_object_end(&w);
+	len += json_writer_len(&w);
+
+	/* Each message ends with a blank line */
+	if ((size_t)len + 2 >= size) {
+		return size;
+	}
+	buf[len++] = '\n';
+	buf[len++] = '\n';
+	buf[len] = '\0';
+
+	return len;
+}
+
+/**
+ * @brief Fan queued events out to /events subscribers
+ *
+ * A subscriber whose send queue is full misses the event rather than
+ * stalling the others.
+ *
+ * @param server HTTP server context
+ */
+static void http_server_sse_drain(struct http_server *server)
+{
+	struct http_event event;
+	char msg[HTTP_SERVER_SSE_MSG_MAX];
+	int64_t now = k_uptime_get();
+	bool ping = (now >= server->sse_next_ping);
+
+	while (k_msgq_get(&server->event_q, &event, K_NO_WAIT) == 0) {
+		size_t len = http_sse_format(&event, msg, sizeof(msg));
+
+		if (len >= sizeof(msg)) {
+			continue;
+		}
+
+		for (size_t i = 0; i < ARRAY_SIZE(server->conns); i++) {
+			struct http_conn *conn = &server->conns[i];
+
+			if (conn->state == HTTP_CONN_EVENTS &&
+			    http_conn_enqueue(conn, msg, len) != 0) {
+				LOG_DBG("Event dropped for slow subscriber");
+			}
+		}
+	}
+
+	if (ping) {
+		server->sse_next_ping = now + HTTP_SERVER_SSE_PING_MS;
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(server->conns); i++) {
+		struct http_conn *conn = &server->conns[i];
+
+		if (conn->state != HTTP_CONN_EVENTS) {
+			continue;
+		}
+
+		/* Comments keep idle streams alive and expose dead peers */
+		if (ping && conn->tx_queue_len == 0) {
+			(void)http_conn_enqueue(conn, ":\n\n", 3);
+		}
+
+		if (conn->tx_queue_len > 0) {
+			http_conn_flush_queue(conn);
+		}
+	}
+}
+
+/**
+ * @brief Forward scanner progress to /events subscribers
+ *
+ * Runs in the scanner's calling context; only queues the event.
+ */
+static void http_server_scan_event(enum wifi_scanner_event scan_event,
+                                   const struct wifi_scan_result *result,
+                                   int status, void *user_data)
+{
+	struct http_server *server = user_data;
+	struct http_event event = {0};
+
+	switch (scan_event) {
+	case WIFI_SCANNER_EVT_STARTED:
+		event.type = HTTP_EVENT_SCAN_STARTED;
+		break;
+	case WIFI_SCANNER_EVT_RESULT:
+		/* Results may come in a burst; the last slot is kept for scan_done */
+		if (k_msgq_num_free_get(&server->event_q) <= 1) {
+			LOG_DBG("Event queue nearly full, scan result not streamed");
+			return;
+		}
+		event.type = HTTP_EVENT_SCAN_RESULT;
+		event.rssi = result->rssi;
+		event.channel = result->channel;
+		event.security = result->security;
+		strncpy(event.ssid, (const char *)result->ssid, sizeof(event.ssid) - 1);
+		break;
+	case WIFI_SCANNER_EVT_DONE:
+		event.type = HTTP_EVENT_SCAN_DONE;
+		event.status = status;
+		break;
+	default:
+		return;
+	}
+
+	(void)http_server_post_event(server, &event);
+}
+
+/**
+ * @brief Finish the current request and prepare for the next one
+ *
+ * Drops the served request from rx_buf, keeping any pipelined bytes that
+ * followed it, or closes the connection if it does not persist.
+ *
+ * @param server HTTP server context
+ * @param conn Client connection
+ */
+static void http_conn_complete(struct http_server *server,
+                               struct http_conn *conn)
+{
+	bool deliver_creds = conn->creds_reply;
+
+	if (conn->resp == HTTP_RESP_WS_UPGRADE && server->running) {
+		static const int one = 1;
+
+		/* Frames may already follow the handshake in rx_buf */
+		conn->rx_len -= conn->req_len;
+		memmove(conn->rx_buf, conn->rx_buf + conn->req_len, conn->rx_len);
+		conn->req_len = 0;
+		conn->resp = HTTP_RESP_NONE;
+		conn->tx_queue_len = 0;
+		conn->close_after_flush = false;
+		conn->state = HTTP_CONN_WEBSOCKET;
+
+		/* Jog commands and state frames are tiny; never hold them back */
+		(void)setsockopt(conn->sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+		LOG_INF("WebSocket client connected");
+		http_ws_process(server, conn);
+		return;
+	}
+
+	if (conn->resp == HTTP_RESP_EVENTS && server->running) {
+		/* Subscribers only listen; anything they send is discarded */
+		conn->rx_len = 0;
+		conn->req_len = 0;
+		conn->resp = HTTP_RESP_NONE;
+		conn->tx_queue_len = 0;
+		conn->close_after_flush = false;
+		conn->state = HTTP_CONN_EVENTS;
+		LOG_INF("Event stream subscriber connected");
+		return;
+	}
+
+	if (conn->keep_alive && server->running) {
+		conn->rx_len -= conn->req_len;
+		memmove(conn->rx_buf, conn->rx_buf + conn->req_len, conn->rx_len);
+		conn->req_len = 0;
+		http_conn_reset_parser(conn);
+		conn->requests++;
+		conn->resp = HTTP_RESP_NONE;
+		conn->creds_reply = false;
+		conn->state = HTTP_CONN_READING;
+		/* A pipelined request is already under way */
+		conn->req_deadline = conn->rx_len ?
+		                     k_uptime_get() + HTTP_SERVER_REQUEST_TIMEOUT_MS : 0;
+	} else {
+		http_conn_close(conn);
+	}
+
+	/* Deliver credentials only after the browser has its reply */
+	if (deliver_creds && server->creds_pending) {
+		server->creds_pending = false;
+		if (server->creds_cb) {
+			server->creds_cb(server->creds_ssid, server->creds_password,
+			                 server->cb_user_data);
+		}
+	}
+}
+
+/**
+ * @brief Send as much of the pending response as the socket accepts
+ *
+ * @param server HTTP server context
+ * @param conn Client connection
+ */
+static void http_conn_write(struct http_server *server, struct http_conn *conn)
+{
+	while (true) {
+		struct msghdr msg = {0};
+		ssize_t ret;
+
+		if (conn->tx_iov_idx == conn->tx_iov_cnt) {
+			conn->tx_iov_idx = 0;
+			conn->tx_iov_cnt = 0;
+			conn->tx_scratch_len = 0;
+			http_conn_fill_batch(server, conn);
+			if (conn->tx_iov_cnt == 0) {
+				break;
+			}
+		}
+
+		msg.msg_iov = &conn->tx_iov[conn->tx_iov_idx];
+		msg.msg_iovlen = conn->tx_iov_cnt - conn->tx_iov_idx;
+
+		ret = sendmsg(conn->sock, &msg, 0);
+		if (ret < 0) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				/* Resume when poll() reports POLLOUT */
+				return;
+			}
+			LOG_DBG("Send failed: %d", errno);
+			http_conn_close(conn);
+			return;
+		}
+		server->stats.response_sends++;
+
+		/* Skip fully sent fragments and trim a partially sent one */
+		while (ret > 0 && conn->tx_iov_idx < conn->tx_iov_cnt) {
+			struct iovec *iov = &conn->tx_iov[conn->tx_iov_idx];
+
+			if ((size_t)ret >= iov->iov_len) {
+				ret -= iov->iov_len;
+				conn->tx_iov_idx++;
+			} else {
+				iov->iov_base = (uint8_t *)iov->iov_base + ret;
+				iov->iov_len -= ret;
+				ret = 0;
+			}
+		}
+
+		conn->last_activity = k_uptime_get();
+		conn->last_tx = conn->last_activity;
+	}
+
+	http_conn_complete(server, conn);
+}
+
+/**
+ * @brief Get the Content-Type of the response being sent
+ *
+ * @param conn Client connection
+ * @return MIME type string
+ */
+static const char *http_resp_content_type(const struct http_conn *conn)
+{
+	switch (conn->resp) {
+	case HTTP_RESP_ASSET:
+		return conn->asset->content_type;
+	case HTTP_RESP_ERROR:
+		return "text/plain";
+	case HTTP_RESP_CONFIG_PAGE:
+		return "text/html";
+	case HTTP_RESP_EVENTS:
+		return "text/event-stream";
+	default:
+		return "application/json";
+	}
+}
+
+/**
+ * @brief Queue a response header and prepare the body generator
+ *
+ * A HEAD request gets the header alone, with the length the body would
+ * have had. Error statuses close the connection once sent.
+ *
+ * @param server HTTP server context
+ * @param conn Client connection
+ * @param status HTTP status code
+ * @param resp Response body kind
+ */
+static void http_conn_respond(struct http_server *server, struct http_conn *conn,
+                              uint16_t status, enum http_resp_kind resp)
+{
+	const char *reason = http_status_reason(status);
+	size_t content_length = 0;
+	int len;
+	int stage = 0;
+	size_t index = 0;
+	size_t frag_len;
+	const char *data;
+
+	server->stats.responses++;
+	conn->status = status;
+	conn->resp = resp;
+	conn->req_deadline = 0;
+	conn->last_tx = k_uptime_get();
+	conn->tx_chunked = false;
+	conn->tx_chunk_end = false;
+	conn->tx_failed = false;
+	conn->tx_head = conn->parser.method == HTTP_METHOD_HEAD;
+
+	/* The rest of a request that failed cannot be trusted */
+	if (status >= 400) {
+		conn->keep_alive = false;
+	}
+
+	if (resp == HTTP_RESP_WS_UPGRADE) {
+		const struct http_span *key = &conn->parser.headers[HTTP_HDR_WS_KEY];
+		char accept[WS_ACCEPT_KEY_LEN];
+
+		(void)ws_accept_key(conn->rx_buf + key->off, key->len, accept);
+		conn->tx_scratch_len = snprintf(conn->tx_buf, sizeof(conn->tx_buf),
+		                                "HTTP/1.1 101 %s\r\n"
+		                                "Upgrade: websocket\r\n"
+		                                "Connection: Upgrade\r\n"
+		                                "Sec-WebSocket-Accept: %s\r\n"
+		                                "\r\n",
+		                                reason, accept);
+		conn->state = HTTP_CONN_WRITING;
+		conn->tx_iov[0].iov_base = conn->tx_buf;
+		conn->tx_iov[0].iov_len = conn->tx_scratch_len;
+		conn->tx_iov_cnt = 1;
+		conn->tx_iov_idx = 0;
+		return;
+	}
+
+	if (resp == HTTP_RESP_CONFIG_PAGE) {
+		http_server_refresh_scan_cache(server);
+	}
+
+	if (http_resp_is_api(resp)) {
+		/* API bodies are streamed as generated rather than sized first.
+		 * HTTP/1.0 has no chunked coding, so the close delimits them.
+		 */
+		conn->api_gen = server->scanner ?
+		                wifi_scanner_get_generation(server->scanner) : 0;
+		if (conn->parser.http11) {
+			conn->tx_chunked = true;
+		} else {
+			conn->keep_alive = false;
+		}
+	} else {
+		/* Size the body by walking the same fragments that will be sent */
+		while ((frag_len = http_body_fragment(server, conn, &stage, &index,
+		                                      conn->tx_buf, sizeof(conn->tx_buf),
+		                                      &data)) > 0) {
+			/* A rendered fragment too large to send fails the response
+			 * then, and the body falls short of this length
+			 */
+			content_length += frag_len;
+		}
+	}
+
+	conn->state = HTTP_CONN_WRITING;
+	conn->resp_stage = 0;
+	conn->resp_index = 0;
+	len = snprintf(conn->tx_buf, sizeof(conn->tx_buf),
+	               "HTTP/1.1 %u %s\r\n"
+	               "Connection: %s\r\n",
+	               status, reason, conn->keep_alive ? "keep-alive" : "close");
+
+	if (status != 304) {
+		len += snprintf(conn->tx_buf + len, sizeof(conn->tx_buf) - len,
+		                "Content-Type: %s\r\n",
+		                http_resp_content_type(conn));
+	}
+
+	if (conn->tx_chunked) {
+		len += snprintf(conn->tx_buf + len, sizeof(conn->tx_buf) - len,
+		                "Transfer-Encoding: chunked\r\n");
+	} else if (status != 304 && !http_resp_is_api(resp) &&
+	           resp != HTTP_RESP_EVENTS) {
+		len += snprintf(conn->tx_buf + len, sizeof(conn->tx_buf) - len,
+		                "Content-Length: %zu\r\n", content_length);
+	}
+
+	if (http_resp_is_api(resp) || resp == HTTP_RESP_EVENTS) {
+		len += snprintf(conn->tx_buf + len, sizeof(conn->tx_buf) - len,
+		                "Cache-Control: no-store\r\n");
+	}
+
+	if (status == 405) {
+		len += snprintf(conn->tx_buf + len, sizeof(conn->tx_buf) - len,
+		                "Allow: %s\r\n", conn->allow);
+	}
+
+	if (resp == HTTP_RESP_ASSET) {
+		/* no-cache: always revalidate, answered cheaply with 304 */
+		len += snprintf(conn->tx_buf + len, sizeof(conn->tx_buf) - len,
+		                "%s"
+		                "ETag: %s\r\n"
+		                "Cache-Control: no-cache\r\n"
+		                "Vary: Accept-Encoding\r\n",
+		                (status == 200) ? "Content-Encoding: gzip\r\n" : "",
+		                conn->asset->etag);
+	}
+
+	len += snprintf(conn->tx_buf + len, sizeof(conn->tx_buf) - len, "\r\n");
+	conn->tx_scratch_len = len;
+
+	/* The header leads the first batch, followed by as much body as fits */
+	conn->tx_iov[0].iov_base = conn->tx_buf;
+	conn->tx_iov[0].iov_len = conn->tx_scratch_len;
+	conn->tx_iov_cnt = 1;
+	conn->tx_iov_idx = 0;
+	http_conn_fill_batch(server, conn);
+}
+
+/**
+ * @brief Start a response with a static asset
+ *
+ * Answers 304 when the client's cached copy is current and 406 when it
+ * cannot accept the gzip-only representation.
+ *
+ * @param server HTTP server context
+ * @param conn Client connection
+ * @param asset Asset to send
+ */
+static void http_conn_send_asset(struct http_server *server, struct http_conn *conn,
+                                 const struct web_asset *asset)
+{
+	struct http_parser *parser = &conn->parser;
+
+	conn->asset = asset;
+
+	if (parser->headers[HTTP_HDR_IF_NONE_MATCH].len &&
+	    http_parser_etag_match(parser, conn->rx_buf, asset->etag)) {
+		http_conn_respond(server, conn, 304, HTTP_RESP_ASSET);
+		return;
+	}
+
+	/* No Accept-Encoding means any coding is acceptable */
+	if (parser->headers[HTTP_HDR_ACCEPT_ENCODING].len &&
+	    !http_parser_header_has(parser, conn->rx_buf,
+	                            HTTP_HDR_ACCEPT_ENCODING, "gzip")) {
+		http_conn_respond(server, conn, 406, HTTP_RESP_ERROR);
+		return;
+	}
+
+	http_conn_respond(server, conn, 200, HTTP_RESP_ASSET);
+}
+
+/* JSON body accepted by POST /api/v1/connect */
+struct http_api_connect {
+	char *ssid;
+	char *password;
+};
+
+static const struct json_obj_descr http_api_connect_descr[] = {
+	JSON_OBJ_DESCR_PRIM(struct http_api_connect, ssid, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_PRIM(struct http_api_connect, password, JSON_TOK_STRING),
+};
+
+/**
+ * @brief Handle POST /api/v1/connect
+ *
+ * Accepts {"ssid": "...", "password": "..."} and hands the credentials
+ * over exactly like the HTML form does.
+ *
+ * @param server HTTP server context
+ * @param conn Client connection
+ */
+static void http_api_connect(struct http_server *server, struct http_conn *conn)
+{
+	struct http_parser *parser = &conn->parser;
+	struct http_api_connect req = {0};
+	int64_t ret;
+
+	/* Parsed in place; the request is discarded once answered */
+	ret = json_obj_parse(conn->rx_buf + parser->body_off, parser->content_length,
+	                     http_api_connect_descr,
+	                     ARRAY_SIZE(http_api_connect_descr), &req);
+	if (ret < 0 || !(ret & BIT(0)) || !req.ssid[0] ||
+	    strlen(req.ssid) >= sizeof(server->creds_ssid) ||
+	    (req.password && strlen(req.password) >= sizeof(server->creds_password))) {
+		conn->keep_alive = false;
+		http_conn_respond(server, conn, 400, HTTP_RESP_API_ERROR);
+		return;
+	}
+
+	strcpy(server->creds_ssid, req.ssid);
+	strcpy(server->creds_password, req.password ? req.password : "");
+
+	LOG_INF("Credentials received via API: SSID=%s", server->creds_ssid);
+	server->creds_pending = true;
+
+	conn->keep_alive = false;
+	conn->creds_reply = true;
+	http_conn_respond(server, conn, 202, HTTP_RESP_API_ACCEPTED);
+}
+
+static void http_api_get_status(struct http_server *server, struct http_conn *conn)
+{
+	http_conn_respond(server, conn, 200, HTTP_RESP_API_STATUS);
+}
+
+static void http_api_get_scan(struct http_server *server, struct http_conn *conn)
+{
+	http_conn_respond(server, conn, 200, HTTP_RESP_API_SCAN);
+}
+
+static void http_api_get_settings(struct http_server *server, struct http_conn *conn)
+{
+	http_conn_respond(server, conn, 200, HTTP_RESP_API_SETTINGS);
+}
+
+HTTP_ROUTE_DEFINE(http_route_api_status, HTTP_METHOD_GET, "/api/v1/status",
+                  http_api_get_status);
+HTTP_ROUTE_DEFINE(http_route_api_scan, HTTP_METHOD_GET, "/api/v1/scan",
+                  http_api_get_scan);
+HTTP_ROUTE_DEFINE(http_route_api_settings, HTTP_METHOD_GET, "/api/v1/settings",
+                  http_api_get_settings);
+HTTP_ROUTE_DEFINE(http_route_api_connect, HTTP_METHOD_POST, "/api/v1/connect",
+                  http_api_connect);
+
+/**
+ * @brief Handle a WebSocket opening handshake on /ws
+ *
+ * @param server HTTP server context
+ * @param conn Client connection
+ */
+static void http_ws_upgrade(struct http_server *server, struct http_conn *conn)
+{
+	struct http_parser *parser = &conn->parser;
+	const struct http_span *version = &parser->headers[HTTP_HDR_WS_VERSION];
+
+	if (!http_parser_header_has(parser, conn->rx_buf, HTTP_HDR_UPGRADE, "websocket") ||
+	    !http_parser_header_has(parser, conn->rx_buf, HTTP_HDR_CONNECTION, "upgrade")) {
+		http_conn_respond(server, conn, 426, HTTP_RESP_ERROR);
+		return;
+	}
+
+	if (!parser->http11 || version->len != 2 ||
+	    memcmp(conn->rx_buf + version->off, "13", 2) != 0 ||
+	    parser->headers[HTTP_HDR_WS_KEY].len != WS_CLIENT_KEY_LEN) {
+		conn->keep_alive = false;
+		http_conn_respond(server, conn, 400, HTTP_RESP_ERROR);
+		return;
+	}
+
+	if (http_server_ws_count(server) >= HTTP_SERVER_MAX_WEBSOCKETS) {
+		LOG_WRN("WebSocket client limit reached");
+		http_conn_respond(server, conn, 503, HTTP_RESP_ERROR);
+		return;
+	}
+
+	http_conn_respond(server, conn, 101, HTTP_RESP_WS_UPGRADE);
+}
+
+HTTP_ROUTE_DEFINE(http_route_ws, HTTP_METHOD_GET, "/ws", http_ws_upgrade);
+
+/**
+ * @brief Subscribe a client to the /events stream
+ *
+ * @param server HTTP server context
+ * @param conn Client connection
+ */
+static void http_sse_subscribe(struct http_server *server, struct http_conn *conn)
+{
+	if (http_server_sse_count(server) >= HTTP_SERVER_MAX_EVENT_STREAMS) {
+		LOG_WRN("Event stream subscriber limit reached");
+		http_conn_respond(server, conn, 503, HTTP_RESP_ERROR);
+		return;
+	}
+
+	/* The stream is delimited by closing the connection */
+	conn->keep_alive = false;
+	http_conn_respond(server, conn, 200, HTTP_RESP_EVENTS);
+}
+
+HTTP_ROUTE_DEFINE(http_route_events, HTTP_METHOD_GET, "/events", http_sse_subscribe);
+
+/**
+ * @brief Handle the HTML form submission on POST /connect
+ *
+ * @param server HTTP server context
+ * @param conn Client connection
+ */
+static void http_form_connect(struct http_server *server, struct http_conn *conn)
+{
+	struct http_parser *parser = &conn->parser;
+
+	if (parse_post_data(conn->rx_buf + parser->body_off, parser->content_length,
+	                    server->creds_ssid, server->creds_password) != 0) {
+		conn->keep_alive = false;
+		http_conn_respond(server, conn, 400, HTTP_RESP_ERROR);
+		return;
+	}
 
-static const char html_page_start[] =
-	"<!DOCTYPE html><html><head>"
-	"<meta name='viewport' content='width=device-width,initial-scale=1'>"
-	"<title>WiFi Setup</title>"
-	"<style>"
-	"body{font-family:Arial,sans-serif;margin:20px;background:#f0f0f0;}"
-	"h1{color:#333;}"
-	".container{background:white;padding:20px;border-radius:8px;max-width:600px;margin:0 auto;}"
-	".network{padding:10px;margin:5px 0;border:1px solid #ddd;border-radius:4px;cursor:pointer;}"
-	".network:hover{background:#e8f4f8;}"
-	".signal{float:right;color:#666;}"
-	"input[type=text],input[type=password]{width:100%;padding:10px;margin:8px 0;border:1px solid #ddd;border-radius:4px;box-sizing:border-box;}"
-	"button{background:#4CAF50;color:white;padding:12px 20px;border:none;border-radius:4px;cursor:pointer;width:100%;font-size:16px;}"
-	"button:hover{background:#45a049;}"
-	".security{color:#666;font-size:0.9em;}"
-	"</style></head><body>"
-	"<div class='container'>"
-	"<h1>WiFi Configuration</h1>"
-	"<p>Select a network or enter credentials manually:</p>";
+	LOG_INF("Credentials received: SSID=%s", server->creds_ssid);
+	server->creds_pending = true;
 
-static const char html_form[] =
-	"<form method='POST' action='/connect'>"
-	"<label>SSID:</label><input type='text' id='ssid' name='ssid' required>"
-	"<label>Password:</label><input type='password' name='password'>"
-	"<button type='submit'>Connect</button>"
-	"</form>";
+	/* The server shuts down once credentials are handed over */
+	conn->keep_alive = false;
+	conn->creds_reply = true;
+	http_conn_send_asset(server, conn, web_asset_find("/success.html", 13));
+}
 
-static const char html_page_end[] =
-	"</div>"
-	"<script>"
-	"function selectNetwork(ssid){document.getElementById('ssid').value=ssid;}"
-	"</script>"
-	"</body></html>";
+HTTP_ROUTE_DEFINE(http_route_connect, HTTP_METHOD_POST, "/connect", http_form_connect);
 
-static const char html_success[] =
-	"HTTP/1.1 200 OK\r\n"
-	"Content-Type: text/html\r\n"
-	"Connection: close\r\n\r\n"
-	"<!DOCTYPE html><html><head><title>Success</title></head><body>"
-	"<h1>WiFi Configuration Saved</h1>"
-	"<p>The device will now attempt to connect to the specified network.</p>"
-	"<p>This setup page will close shortly.</p>"
-	"</body></html>";
+/*
+ * Route lookup
+ *
+ * Routes come from a linker section, so their number and contents are
+ * only known at run time. On first use the table below is filled with a
+ * perfect hash: a seed is searched for that sends every
+ * (method, path) pair to its own slot. A lookup then costs one hash and
+ * one string compare however many routes are registered.
+ */
+#define HTTP_ROUTE_SLOTS 64
+#define HTTP_ROUTE_EMPTY UINT8_MAX
+#define HTTP_ROUTE_SEED_TRIES 4096
+
+static uint8_t http_route_slot[HTTP_ROUTE_SLOTS];
+static uint32_t http_route_seed;
+static bool http_route_hashed;  /* false: fall back to a linear scan */
+static bool http_route_built;
 
 /**
- * @brief Parse HTTP POST data for credentials
- *
- * @param data POST data string
- * @param ssid Output buffer for SSID
- * @param password Output buffer for password
- * @return 0 on success, -1 on failure
+ * @brief Seeded FNV-1a over method and path, with a final avalanche
  */
-static int parse_post_data(const char *data, char *ssid, char *password)
+static uint32_t http_route_hash(uint32_t seed, enum http_method method,
+                                const char *path, size_t len)
 {
-	const char *ssid_start, *ssid_end;
-	const char *pass_start, *pass_end;
+	uint32_t h = 2166136261u ^ seed;
 
-	/* Find SSID */
-	ssid_start = strstr(data, "ssid=");
-	if (!ssid_start) {
-		return -1;
+	h = (h ^ (uint8_t)method) * 16777619u;
+	for (size_t i = 0; i < len; i++) {
+		h = (h ^ (uint8_t)path[i]) * 16777619u;
 	}
-	ssid_start += 5;  /* Skip "ssid=" */
 
-	ssid_end = strchr(ssid_start, '&');
-	if (!ssid_end) {
-		ssid_end = ssid_start + strlen(ssid_start);
+	/* FNV's low bits mix poorly; the slot index uses only those */
+	h ^= h >> 16;
+	h *= 0x7feb352du;
+	h ^= h >> 15;
+
+	return h;
+}
+
+/**
+ * @brief Try to place every route in its own slot using one seed
+ *
+ * @return true if no two routes collide
+ */
+static bool http_route_try_seed(uint32_t seed, size_t count)
+{
+	memset(http_route_slot, HTTP_ROUTE_EMPTY, sizeof(http_route_slot));
+
+	for (size_t i = 0; i < count; i++) {
+		const struct http_route *route;
+		uint32_t slot;
+
+		STRUCT_SECTION_GET(http_route, i, &route);
+		slot = http_route_hash(seed, route->method, route->path,
+		                       strlen(route->path)) % HTTP_ROUTE_SLOTS;
+		if (http_route_slot[slot] != HTTP_ROUTE_EMPTY) {
+			return false;
+		}
+		http_route_slot[slot] = i;
 	}
 
-	size_t ssid_len = ssid_end - ssid_start;
-	if (ssid_len > 32) {
-		ssid_len = 32;
+	return true;
+}
+
+/**
+ * @brief Build the route hash table
+ */
+static void http_route_table_build(void)
+{
+	size_t count;
+
+	if (http_route_built) {
+		return;
 	}
-	strncpy(ssid, ssid_start, ssid_len);
-	ssid[ssid_len] = '\0';
+	http_route_built = true;
 
-	/* URL decode SSID (replace + with space, handle %XX) */
-	for (size_t i = 0; ssid[i]; i++) {
-		if (ssid[i] == '+') {
-			ssid[i] = ' ';
+	STRUCT_SECTION_COUNT(http_route, &count);
+
+	if (count <= HTTP_ROUTE_SLOTS / 2) {
+		for (uint32_t seed = 0; seed < HTTP_ROUTE_SEED_TRIES; seed++) {
+			if (http_route_try_seed(seed, count)) {
+				http_route_seed = seed;
+				http_route_hashed = true;
+				LOG_DBG("Route table: %zu routes, seed %u", count, seed);
+				return;
+			}
 		}
 	}
 
-	/* Find password */
-	pass_start = strstr(data, "password=");
-	if (pass_start) {
-		pass_start += 9;  /* Skip "password=" */
-		pass_end = strchr(pass_start, '&');
-		if (!pass_end) {
-			pass_end = pass_start + strlen(pass_start);
+	/* Duplicate routes never separate; still usable, just slower */
+	LOG_WRN("No perfect hash for %zu routes, using linear lookup", count);
+}
+
+/**
+ * @brief Find the route registered for a method and path
+ *
+ * @param method Request method
+ * @param path Request path, without query string
+ * @param len Length of path
+ * @return Route, or NULL if none matches
+ */
+static const struct http_route *http_route_find(enum http_method method,
+                                                const char *path, size_t len)
+{
+	const struct http_route *route;
+
+	if (http_route_hashed) {
+		uint8_t idx = http_route_slot[http_route_hash(http_route_seed, method,
+		                                              path, len) % HTTP_ROUTE_SLOTS];
+
+		if (idx == HTTP_ROUTE_EMPTY) {
+			return NULL;
 		}
 
-		size_t pass_len = pass_end - pass_start;
-		if (pass_len > 64) {
-			pass_len = 64;
+		STRUCT_SECTION_GET(http_route, idx, &route);
+		if (route->method == method && strlen(route->path) == len &&
+		    memcmp(route->path, path, len) == 0) {
+			return route;
 		}
-		strncpy(password, pass_start, pass_len);
-		password[pass_len] = '\0';
+		return NULL;
+	}
 
-		/* URL decode password */
-		for (size_t i = 0; password[i]; i++) {
-			if (password[i] == '+') {
-				password[i] = ' ';
-			}
+	STRUCT_SECTION_FOREACH(http_route, candidate) {
+		if (candidate->method == method && strlen(candidate->path) == len &&
+		    memcmp(candidate->path, path, len) == 0) {
+			return candidate;
 		}
-	} else {
-		password[0] = '\0';
 	}
 
-	return 0;
+	return NULL;
+}
+
+/**
+ * @brief Build the Allow header for a path registered with other methods
+ *
+ * @param path Request path, without query string
+ * @param len Length of path
+ * @return Allow header value, or NULL if the path is not registered
+ */
+static const char *http_route_allow(const char *path, size_t len)
+{
+	static const char *const allow[] = {
+		NULL, "GET", "POST", "GET, POST",
+		"PUT", "GET, PUT", "POST, PUT", "GET, POST, PUT",
+	};
+	static const enum http_method methods[] = {
+		HTTP_METHOD_GET, HTTP_METHOD_POST, HTTP_METHOD_PUT,
+	};
+	unsigned int mask = 0;
+
+	for (size_t i = 0; i < ARRAY_SIZE(methods); i++) {
+		if (http_route_find(methods[i], path, len)) {
+			mask |= BIT(i);
+		}
+	}
+
+	return allow[mask];
 }
 
 /**
- * @brief Handle HTTP client connection
+ * @brief Route a fully parsed request and start its response
  *
  * @param server HTTP server context
- * @param client_sock Client socket
+ * @param conn Client connection
  */
-static void handle_client(struct http_server *server, int client_sock)
+static void http_conn_dispatch(struct http_server *server, struct http_conn *conn)
 {
-	char buffer[1024];
-	int ret;
+	struct http_parser *parser = &conn->parser;
+	const char *path = conn->rx_buf + parser->path.off;
+	const char *query = memchr(path, '?', parser->path.len);
+	size_t path_len = query ? (size_t)(query - path) : parser->path.len;
+	const struct http_route *route;
+	const struct web_asset *asset;
+	bool is_api;
+
+	conn->req_len = http_parser_request_len(parser);
+	LOG_DBG("HTTP request received: %zu bytes", conn->req_len);
+
+	/* HTTP/1.1 defaults to keep-alive, HTTP/1.0 to close */
+	if (parser->http11) {
+		conn->keep_alive = !http_parser_header_has(parser, conn->rx_buf,
+		                                           HTTP_HDR_CONNECTION, "close");
+	} else {
+		conn->keep_alive = http_parser_header_has(parser, conn->rx_buf,
+		                                          HTTP_HDR_CONNECTION, "keep-alive");
+	}
 
-	/* Receive HTTP request */
-	ret = recv(client_sock, buffer, sizeof(buffer) - 1, 0);
-	if (ret <= 0) {
-		close(client_sock);
+	/* Registered endpoints first */
+	route = http_route_find(parser->method, path, path_len);
+	if (route) {
+		route->handler(server, conn);
 		return;
 	}
-	buffer[ret] = '\0';
 
-	LOG_DBG("HTTP request received: %d bytes", ret);
+	is_api = path_len >= 8 && memcmp(path, "/api/v1/", 8) == 0;
+
+	conn->allow = http_route_allow(path, path_len);
+	if (conn->allow) {
+		http_conn_respond(server, conn, 405,
+		                  is_api ? HTTP_RESP_API_ERROR : HTTP_RESP_ERROR);
+	} else if (is_api) {
+		http_conn_respond(server, conn, 404, HTTP_RESP_API_ERROR);
+	} else if (parser->method == HTTP_METHOD_OTHER) {
+		http_conn_respond(server, conn, 501, HTTP_RESP_ERROR);
+	} else if (parser->method != HTTP_METHOD_GET &&
+	           parser->method != HTTP_METHOD_HEAD) {
+		/* Pages are read-only; forms post to their own routes */
+		conn->allow = "GET, HEAD";
+		http_conn_respond(server, conn, 405, HTTP_RESP_ERROR);
+	} else if ((asset = web_asset_find(path, path_len)) != NULL) {
+		http_conn_send_asset(server, conn, asset);
+	} else {
+		http_conn_respond(server, conn, 200, HTTP_RESP_CONFIG_PAGE);
+	}
+}
 
-	/* Check if POST request with credentials */
-	if (strncmp(buffer, "POST /connect", 13) == 0) {
-		char ssid[33] = {0};
-		char password[65] = {0};
+/**
+ * @brief Serve every complete request buffered on a connection
+ *
+ * The parser resumes where it stopped on the previous call, so bytes are
+ * examined once no matter how the request was segmented. Pipelined
+ * requests are answered strictly in order; processing pauses whenever a
+ * response cannot be flushed without blocking.
+ *
+ * @param server HTTP server context
+ * @param conn Client connection
+ */
+static void http_conn_process(struct http_server *server, struct http_conn *conn)
+{
+	while (conn->state == HTTP_CONN_READING) {
+		struct http_parser *parser = &conn->parser;
+		int ret = http_parser_execute(parser, conn->rx_buf, conn->rx_len);
+
+		/* Reject bodies that cannot fit before waiting for them */
+		if (ret >= 0 && parser->state >= HTTP_PARSER_BODY &&
+		    http_parser_request_len(parser) > sizeof(conn->rx_buf)) {
+			ret = -EMSGSIZE;
+		}
 
-		/* Find POST data (after \r\n\r\n) */
-		const char *post_data = strstr(buffer, "\r\n\r\n");
-		if (post_data && parse_post_data(post_data + 4, ssid, password) == 0) {
-			LOG_INF("Credentials received: SSID=%s", ssid);
+		if (ret == HTTP_PARSE_INCOMPLETE) {
+			return;
+		}
 
-			/* Send success response */
-			send(client_sock, html_success, strlen(html_success), 0);
+		if (ret < 0) {
+			uint16_t status = 400;
 
-			/* Call credentials callback */
-			if (server->creds_cb) {
-				server->creds_cb(ssid, password, server->cb_user_data);
+			if (ret == -EMSGSIZE) {
+				status = (parser->state < HTTP_PARSER_BODY) ? 431 : 413;
+				server->stats.oversize++;
+			} else if (ret == -ENOTSUP) {
+				/* Transfer-Encoding; the body cannot be skipped */
+				status = 501;
 			}
+			LOG_WRN("Rejecting request: %d", status);
+
+			conn->keep_alive = false;
+			http_conn_respond(server, conn, status, HTTP_RESP_ERROR);
+		} else {
+			http_conn_dispatch(server, conn);
 		}
-	} else {
-		/* Send configuration page */
-		send(client_sock, html_header, strlen(html_header), 0);
-		send(client_sock, html_page_start, strlen(html_page_start), 0);
 
-		/* Add scan results if available */
-		if (server->scanner) {
-			size_t count;
-			const struct wifi_scan_result *results =
-				wifi_scanner_get_results(server->scanner, &count);
+		http_conn_write(server, conn);
+	}
+}
+
+/**
+ * @brief Read available request bytes from a client
+ *
+ * @param server HTTP server context
+ * @param conn Client connection
+ */
+static void http_conn_read(struct http_server *server, struct http_conn *conn)
+{
+	ssize_t ret;
+
+	ret = recv(conn->sock, conn->rx_buf + conn->rx_len,
+	           sizeof(conn->rx_buf) - conn->rx_len, 0);
+	if (ret < 0) {
+		if (errno != EAGAIN && errno != EWOULDBLOCK) {
+			http_conn_close(conn);
+		}
+		return;
+	}
 
-			if (results && count > 0) {
-				char network_html[256];
+	if (ret == 0) {
+		/* Peer closed the connection */
+		http_conn_close(conn);
+		return;
+	}
 
-				send(client_sock, "<h2>Available Networks:</h2>", 28, 0);
+	conn->rx_len += ret;
+	conn->last_activity = k_uptime_get();
 
-				for (size_t i = 0; i < count; i++) {
-					int signal_bars = (results[i].rssi + 100) / 15;
-					if (signal_bars < 0) signal_bars = 0;
-					if (signal_bars > 4) signal_bars = 4;
+	if (conn->state == HTTP_CONN_READING && !conn->req_deadline) {
+		conn->req_deadline = conn->last_activity + HTTP_SERVER_REQUEST_TIMEOUT_MS;
+	}
 
-					snprintf(network_html, sizeof(network_html),
-					         "<div class='network' onclick='selectNetwork(\"%s\")'>"
-					         "%s <span class='signal'>Signal: %d dBm</span><br>"
-					         "<span class='security'>%s</span></div>",
-					         results[i].ssid, results[i].ssid, results[i].rssi,
-					         wifi_scanner_security_to_string(results[i].security));
+	if (conn->state == HTTP_CONN_WEBSOCKET) {
+		http_ws_process(server, conn);
+	} else if (conn->state == HTTP_CONN_EVENTS) {
+		conn->rx_len = 0;
+	} else {
+		http_conn_process(server, conn);
+	}
+}
 
-					send(client_sock, network_html, strlen(network_html), 0);
-				}
+/**
+ * @brief Find an idle keep-alive connection that may be evicted
+ *
+ * @param server HTTP server context
+ * @return Least recently active idle connection, or NULL if none
+ */
+static struct http_conn *http_server_idle_conn(struct http_server *server)
+{
+	struct http_conn *idle = NULL;
+
+	for (size_t i = 0; i < ARRAY_SIZE(server->conns); i++) {
+		struct http_conn *conn = &server->conns[i];
+
+		if (conn->state == HTTP_CONN_READING && conn->rx_len == 0 &&
+		    conn->requests > 0 &&
+		    (!idle || conn->last_activity < idle->last_activity)) {
+			idle = conn;
+		}
+	}
+
+	return idle;
+}
+
+/**
+ * @brief Enforce connection deadlines
+ *
+ * Closes keep-alive connections that have been idle too long, answers
+ * requests that were not received in time with 408 and drops clients
+ * that stopped reading their output.
+ *
+ * @param server HTTP server context
+ */
+static void http_server_expire(struct http_server *server)
+{
+	int64_t now = k_uptime_get();
+
+	for (size_t i = 0; i < ARRAY_SIZE(server->conns); i++) {
+		struct http_conn *conn = &server->conns[i];
+
+		switch (conn->state) {
+		case HTTP_CONN_READING:
+			if (conn->req_deadline && now >= conn->req_deadline) {
+				LOG_WRN("Request not received in time");
+				server->stats.request_timeouts++;
+				conn->keep_alive = false;
+				http_conn_respond(server, conn, 408, HTTP_RESP_ERROR);
+				http_conn_write(server, conn);
+			} else if (!conn->req_deadline &&
+			           now - conn->last_activity >= HTTP_SERVER_KEEPALIVE_TIMEOUT_MS) {
+				LOG_DBG("Closing idle connection");
+				server->stats.idle_closed++;
+				http_conn_close(conn);
 			}
+			break;
+		case HTTP_CONN_WRITING:
+		case HTTP_CONN_WEBSOCKET:
+		case HTTP_CONN_EVENTS:
+			if ((conn->state == HTTP_CONN_WRITING || conn->tx_queue_len > 0) &&
+			    now - conn->last_tx >= HTTP_SERVER_SEND_TIMEOUT_MS) {
+				LOG_WRN("Dropping client that stopped reading");
+				server->stats.send_timeouts++;
+				http_conn_close(conn);
+			}
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+/**
+ * @brief Accept a pending client into a free connection slot
+ *
+ * When every slot is taken, the longest idle keep-alive connection is
+ * closed to make room.
+ *
+ * @param server HTTP server context
+ */
+static void http_server_accept(struct http_server *server)
+{
+	struct sockaddr_in client_addr;
+	socklen_t client_addr_len = sizeof(client_addr);
+	struct http_conn *conn = NULL;
+	int client_sock;
+
+	client_sock = accept(server->listen_sock, (struct sockaddr *)&client_addr,
+	                     &client_addr_len);
+	if (client_sock < 0) {
+		if (errno != EAGAIN && errno != EWOULDBLOCK) {
+			LOG_ERR("Accept failed: %d", errno);
+			printk("HTTP server: accept failed: %d\n", errno);
+		}
+		return;
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(server->conns); i++) {
+		if (server->conns[i].state == HTTP_CONN_FREE) {
+			conn = &server->conns[i];
+			break;
+		}
+	}
+
+	if (!conn) {
+		conn = http_server_idle_conn(server);
+		if (!conn) {
+			server->stats.refused++;
+			close(client_sock);
+			return;
 		}
+		LOG_DBG("Evicting idle keep-alive connection");
+		server->stats.idle_evicted++;
+		http_conn_close(conn);
+	}
 
-		/* Send form and end of page */
-		send(client_sock, "<h2>Enter Credentials:</h2>", 28, 0);
-		send(client_sock, html_form, strlen(html_form), 0);
-		send(client_sock, html_page_end, strlen(html_page_end), 0);
+	if (fcntl(client_sock, F_SETFL, O_NONBLOCK) < 0) {
+		LOG_ERR("Failed to make client socket non-blocking: %d", errno);
+		close(client_sock);
+		return;
 	}
 
-	close(client_sock);
+	LOG_DBG("Client connected");
+	printk("HTTP server: client connected from %d.%d.%d.%d\n",
+	       ((uint8_t *)&client_addr.sin_addr.s_addr)[0],
+	       ((uint8_t *)&client_addr.sin_addr.s_addr)[1],
+	       ((uint8_t *)&client_addr.sin_addr.s_addr)[2],
+	       ((uint8_t *)&client_addr.sin_addr.s_addr)[3]);
+
+	conn->sock = client_sock;
+	conn->state = HTTP_CONN_READING;
+	conn->rx_len = 0;
+	conn->requests = 0;
+	conn->req_deadline = 0;
+	http_conn_reset_parser(conn);
+	conn->last_activity = k_uptime_get();
 }
 
 /**
  * @brief HTTP server thread function
  *
+ * Multiplexes the listening socket and all client connections in a single
+ * poll() loop so that one slow client cannot stall the others.
+ *
  * @param arg1 Pointer to http_server context
  * @param arg2 Unused
  * @param arg3 Unused
@@ -226,7 +2157,11 @@ static void handle_client(struct http_server *server, int client_sock)
 static void http_server_thread(void *arg1, void *arg2, void *arg3)
 {
 	struct http_server *server = (struct http_server *)arg1;
+	struct pollfd fds[2 + HTTP_SERVER_MAX_CONNECTIONS];
+	struct http_conn *fd_conn[2 + HTTP_SERVER_MAX_CONNECTIONS];
 	struct sockaddr_in addr;
+	k_spinlock_key_t key;
+	int wake_fd;
 	int ret;
 
 	ARG_UNUSED(arg2);
@@ -234,6 +2169,11 @@ static void http_server_thread(void *arg1, void *arg2, void *arg3)
 
 	LOG_INF("HTTP server thread started");
 
+	for (size_t i = 0; i < ARRAY_SIZE(server->conns); i++) {
+		server->conns[i].sock = -1;
+		server->conns[i].state = HTTP_CONN_FREE;
+	}
+
 	/* Create listening socket */
 	server->listen_sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
 	if (server->listen_sock < 0) {
@@ -269,50 +2209,215 @@ static void http_server_thread(void *arg1, void *arg2, void *arg3)
 		return;
 	}
 
+	/* accept() must never block the loop */
+	if (fcntl(server->listen_sock, F_SETFL, O_NONBLOCK) < 0) {
+		LOG_ERR("Failed to make listen socket non-blocking: %d", errno);
+		close(server->listen_sock);
+		server->state = HTTP_SERVER_FAILED;
+		return;
+	}
+
+	/* Lets other threads interrupt poll() for events and stop requests */
+	wake_fd = zvfs_eventfd(0, ZVFS_EFD_NONBLOCK);
+	if (wake_fd < 0) {
+		LOG_WRN("No wakeup fd (%d), falling back to the poll timeout", errno);
+	}
+	key = k_spin_lock(&server->wake_lock);
+	server->wake_fd = wake_fd;
+	k_spin_unlock(&server->wake_lock, key);
+
 	server->state = HTTP_SERVER_RUNNING;
+	server->sse_next_ping = k_uptime_get() + HTTP_SERVER_SSE_PING_MS;
 	LOG_INF("HTTP server listening on port %d", HTTP_SERVER_PORT);
 	printk("HTTP server: listening on port %d (ready for connections)\n", HTTP_SERVER_PORT);
 
-	/* Accept and handle connections */
+	/* Multiplex listen socket and clients */
 	while (server->running) {
-		struct sockaddr_in client_addr;
-		socklen_t client_addr_len = sizeof(client_addr);
+		int nfds = 0;
+		int timeout = HTTP_SERVER_POLL_TIMEOUT_MS;
+		bool slot_free = false;
+
+		http_server_expire(server);
+		http_server_ws_push(server);
+		http_server_sse_drain(server);
+
+		/* Wake up in time for the next telemetry push */
+		if (http_server_ws_count(server) > 0) {
+			timeout = CLAMP(server->ws_next_push - k_uptime_get(), 0, timeout);
+		}
+
+		for (size_t i = 0; i < ARRAY_SIZE(server->conns); i++) {
+			struct http_conn *conn = &server->conns[i];
+
+			if (conn->state == HTTP_CONN_FREE) {
+				slot_free = true;
+				continue;
+			}
+
+			fds[nfds].fd = conn->sock;
+			if (conn->state == HTTP_CONN_WEBSOCKET ||
+			    conn->state == HTTP_CONN_EVENTS) {
+				fds[nfds].events = POLLIN | (conn->tx_queue_len ? POLLOUT : 0);
+			} else {
+				fds[nfds].events = (conn->state == HTTP_CONN_WRITING) ?
+				                   POLLOUT : POLLIN;
+			}
+			fds[nfds].revents = 0;
+			fd_conn[nfds++] = conn;
+		}
 
-		int client_sock = accept(server->listen_sock,
-		                          (struct sockaddr *)&client_addr,
-		                          &client_addr_len);
+		/* Leave new clients in the backlog while all slots are busy */
+		if (slot_free || http_server_idle_conn(server)) {
+			fds[nfds].fd = server->listen_sock;
+			fds[nfds].events = POLLIN;
+			fds[nfds].revents = 0;
+			fd_conn[nfds++] = NULL;
+		}
+
+		if (server->wake_fd >= 0) {
+			fds[nfds].fd = server->wake_fd;
+			fds[nfds].events = POLLIN;
+			fds[nfds].revents = 0;
+			fd_conn[nfds++] = NULL;
+		}
 
-		if (client_sock < 0) {
-			if (server->running) {
-				LOG_ERR("Accept failed: %d", errno);
-				printk("HTTP server: accept failed: %d\n", errno);
+		ret = poll(fds, nfds, timeout);
+		if (ret < 0) {
+			if (errno == EINTR) {
+				continue;
 			}
+			LOG_ERR("Poll failed: %d", errno);
 			break;
 		}
 
-		LOG_DBG("Client connected");
-		printk("HTTP server: client connected from %d.%d.%d.%d\n",
-		       ((uint8_t *)&client_addr.sin_addr.s_addr)[0],
-		       ((uint8_t *)&client_addr.sin_addr.s_addr)[1],
-		       ((uint8_t *)&client_addr.sin_addr.s_addr)[2],
-		       ((uint8_t *)&client_addr.sin_addr.s_addr)[3]);
-		handle_client(server, client_sock);
+		for (int i = 0; i < nfds && server->running; i++) {
+			struct http_conn *conn = fd_conn[i];
+
+			if (!fds[i].revents) {
+				continue;
+			}
+
+			if (!conn && fds[i].fd == server->wake_fd) {
+				zvfs_eventfd_t value;
+
+				/* Reset the counter; the queue is drained at the loop top */
+				(void)zvfs_eventfd_read(server->wake_fd, &value);
+			} else if (!conn) {
+				http_server_accept(server);
+			} else if (fds[i].revents & (POLLERR | POLLHUP | POLLNVAL)) {
+				http_conn_close(conn);
+			} else if (conn->state == HTTP_CONN_READING) {
+				http_conn_read(server, conn);
+			} else if (conn->state == HTTP_CONN_WRITING) {
+				http_conn_write(server, conn);
+				http_conn_process(server, conn);
+			} else if (conn->state == HTTP_CONN_WEBSOCKET ||
+			           conn->state == HTTP_CONN_EVENTS) {
+				enum http_conn_state state = conn->state;
+
+				if (fds[i].revents & POLLOUT) {
+					http_conn_flush_queue(conn);
+				}
+				if (conn->state == state && (fds[i].revents & POLLIN)) {
+					http_conn_read(server, conn);
+				}
+			}
+		}
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(server->conns); i++) {
+		struct http_conn *conn = &server->conns[i];
+
+		/* Best effort: tell WebSocket clients why they are dropped */
+		if (conn->state == HTTP_CONN_WEBSOCKET && !conn->close_after_flush) {
+			http_ws_close(conn, WS_CLOSE_GOING_AWAY);
+			http_conn_flush_queue(conn);
+		}
+
+		if (conn->state != HTTP_CONN_FREE) {
+			http_conn_close(conn);
+		}
 	}
 
+	wifi_scanner_set_event_cb(server->scanner, NULL, NULL);
+
 	close(server->listen_sock);
+	server->listen_sock = -1;
+
+	/* No writer may touch the fd once it is closed and its number reused */
+	key = k_spin_lock(&server->wake_lock);
+	wake_fd = server->wake_fd;
+	server->wake_fd = -1;
+	k_spin_unlock(&server->wake_lock, key);
+	if (wake_fd >= 0) {
+		close(wake_fd);
+	}
+
 	server->state = HTTP_SERVER_STOPPED;
 	LOG_INF("HTTP server thread stopped");
 }
 
+/**
+ * @brief Interrupt the server thread's poll()
+ *
+ * Callable from any thread.
+ *
+ * @param server HTTP server context
+ */
+static void http_server_wake(struct http_server *server)
+{
+	k_spinlock_key_t key = k_spin_lock(&server->wake_lock);
+
+	if (server->wake_fd >= 0) {
+		(void)zvfs_eventfd_write(server->wake_fd, 1);
+	}
+
+	k_spin_unlock(&server->wake_lock, key);
+}
+
+/**
+ * @brief Wait for a previous server thread to finish exiting
+ *
+ * The thread object must not be reused or cleared while it still runs.
+ *
+ * @param server HTTP server context
+ * @return 0 if no thread is left, -EBUSY otherwise
+ */
+static int http_server_reap(struct http_server *server)
+{
+	if (!server->server_tid) {
+		return 0;
+	}
+
+	if (k_thread_join(&server->server_thread,
+	                  K_MSEC(HTTP_SERVER_STOP_TIMEOUT_MS)) != 0) {
+		LOG_ERR("HTTP server thread still running");
+		return -EBUSY;
+	}
+
+	server->server_tid = NULL;
+	return 0;
+}
+
 int http_server_init(struct http_server *server, struct wifi_scanner *scanner)
 {
 	if (!server) {
 		return -EINVAL;
 	}
 
+	if (http_server_reap(server) != 0) {
+		return -EBUSY;
+	}
+
+	http_route_table_build();
+
 	memset(server, 0, sizeof(struct http_server));
 	server->state = HTTP_SERVER_STOPPED;
 	server->scanner = scanner;
+	server->listen_sock = -1;
+	server->wake_fd = -1;
+	k_msgq_init(&server->event_q, server->event_q_buf,
+	            sizeof(struct http_event), HTTP_SERVER_EVENT_QUEUE_LEN);
 
 	LOG_INF("HTTP server initialized");
 	return 0;
@@ -326,15 +2431,23 @@ int http_server_start(struct http_server *server,
 		return -EINVAL;
 	}
 
-	if (server->state == HTTP_SERVER_RUNNING) {
+	if (server->state == HTTP_SERVER_RUNNING ||
+	    server->state == HTTP_SERVER_STARTING) {
 		LOG_WRN("HTTP server already running");
 		return -EALREADY;
 	}
 
+	/* A stop requested from the server thread may still be completing */
+	if (http_server_reap(server) != 0) {
+		return -EBUSY;
+	}
+
 	server->creds_cb = creds_cb;
 	server->cb_user_data = user_data;
 	server->running = true;
 	server->state = HTTP_SERVER_STARTING;
+	k_msgq_purge(&server->event_q);
+	wifi_scanner_set_event_cb(server->scanner, http_server_scan_event, server);
 
 	/* Create server thread */
 	server->server_tid = k_thread_create(
@@ -358,29 +2471,91 @@ int http_server_start(struct http_server *server,
 	return 0;
 }
 
+void http_server_respond(struct http_server *server, struct http_conn *conn,
+                         uint16_t status, enum http_resp_kind resp)
+{
+	http_conn_respond(server, conn, status, resp);
+}
+
+void http_server_respond_json(struct http_server *server, struct http_conn *conn,
+                              uint16_t status, http_json_render_t render)
+{
+	conn->json_render = render;
+	http_conn_respond(server, conn, status, HTTP_RESP_API_JSON);
+}
+
+int http_server_post_event(struct http_server *server,
+                           const struct http_event *event)
+{
+	if (!server || !event) {
+		return -EINVAL;
+	}
+
+	if (server->state != HTTP_SERVER_RUNNING) {
+		return -ENODEV;
+	}
+
+	if (k_msgq_put(&server->event_q, event, K_NO_WAIT) != 0) {
+		return -ENOBUFS;
+	}
+
+	http_server_wake(server);
+
+	return 0;
+}
+
+void http_server_get_stats(const struct http_server *server,
+                           struct http_server_stats *stats)
+{
+	if (server && stats) {
+		*stats = server->stats;
+	}
+}
+
+void http_server_set_settings_cb(struct http_server *server,
+                                 http_server_settings_cb_t settings_cb)
+{
+	if (server) {
+		server->settings_cb = settings_cb;
+	}
+}
+
+void http_server_set_ws_callbacks(struct http_server *server,
+                                  http_server_jog_cb_t jog_cb,
+                                  http_server_telemetry_cb_t telemetry_cb)
+{
+	if (server) {
+		server->jog_cb = jog_cb;
+		server->telemetry_cb = telemetry_cb;
+	}
+}
+
 int http_server_stop(struct http_server *server)
 {
 	if (!server) {
 		return -EINVAL;
 	}
 
-	if (server->state != HTTP_SERVER_RUNNING) {
+	if (server->state != HTTP_SERVER_RUNNING &&
+	    server->state != HTTP_SERVER_STARTING) {
 		return -EALREADY;
 	}
 
 	LOG_INF("Stopping HTTP server...");
 
+	/* The server thread closes its own sockets, so no descriptor is
+	 * closed from two threads.
+	 */
 	server->running = false;
+	server->state = HTTP_SERVER_STOPPING;
+	http_server_wake(server);
 
-	/* Close socket to unblock accept() */
-	if (server->listen_sock >= 0) {
-		close(server->listen_sock);
+	/* Joining ourselves would deadlock; the loop exits on return */
+	if (k_current_get() == &server->server_thread) {
+		return 0;
 	}
 
-	/* Wait for thread to finish */
-	k_thread_join(&server->server_thread, K_SECONDS(5));
-
-	return 0;
+	return http_server_reap(server) ? -ETIMEDOUT : 0;
 }
 
 enum http_server_state http_server_get_state(struct http_server *server)
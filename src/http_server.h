@@ -9,7 +9,12 @@
 #pragma once
 
 #include <zephyr/kernel.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/sys/iterable_sections.h>
 #include "wifi_scanner.h"
+#include "http_parser.h"
+#include "web_assets.h"
+#include "json_writer.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -19,7 +24,54 @@ extern "C" {
 #define HTTP_SERVER_PORT 80
 
 /** Maximum number of concurrent connections */
-#define HTTP_SERVER_MAX_CONNECTIONS 2
+#define HTTP_SERVER_MAX_CONNECTIONS CONFIG_SLIDER_HTTP_MAX_CONNECTIONS
+
+/** Per-connection request buffer size */
+#define HTTP_SERVER_RX_BUF_SIZE CONFIG_SLIDER_HTTP_RX_BUF_SIZE
+
+/** Largest request body accepted (form submissions) */
+#define HTTP_SERVER_MAX_BODY CONFIG_SLIDER_HTTP_MAX_BODY
+
+/** Size of the cached, pre-rendered network list */
+#define HTTP_SERVER_SCAN_CACHE_SIZE CONFIG_SLIDER_HTTP_SCAN_CACHE_SIZE
+
+/** Maximum concurrent WebSocket clients */
+#define HTTP_SERVER_MAX_WEBSOCKETS CONFIG_SLIDER_HTTP_MAX_WEBSOCKETS
+
+/** Interval between device state pushes to WebSocket clients */
+#define HTTP_SERVER_WS_TELEMETRY_MS CONFIG_SLIDER_WS_TELEMETRY_INTERVAL_MS
+
+/** Maximum concurrent Server-Sent Events subscribers */
+#define HTTP_SERVER_MAX_EVENT_STREAMS CONFIG_SLIDER_HTTP_MAX_EVENT_STREAMS
+
+/** Events buffered between producers and the server thread */
+#define HTTP_SERVER_EVENT_QUEUE_LEN CONFIG_SLIDER_HTTP_EVENT_QUEUE_LEN
+
+/**
+ * @name WebSocket message types
+ *
+ * Binary messages on /ws start with a type byte; multi-byte fields are
+ * little-endian.
+ * @{
+ */
+/** Device to client: u8 type, u8 WiFi state, s8 RSSI, u8 WebSocket
+ *  clients, s32 position, u32 uptime (ms)
+ */
+#define HTTP_WS_MSG_STATE 0x01
+/** Client to device: u8 type, s16 velocity, u16 duration (ms, 0 = hold) */
+#define HTTP_WS_MSG_JOG 0x10
+/** Client to device: u8 type */
+#define HTTP_WS_MSG_STOP 0x11
+/** @} */
+
+/** Per-connection scratch buffer for the header and rendered fragments */
+#define HTTP_SERVER_TX_BUF_SIZE 512
+
+/** Maximum fragments gathered into one sendmsg() call */
+#define HTTP_SERVER_TX_IOV_MAX 16
+
+/** Target bytes per sendmsg() call, roughly one TCP segment */
+#define HTTP_SERVER_TX_BATCH_SIZE 1460
 
 /**
  * @brief HTTP server state
@@ -28,9 +80,106 @@ enum http_server_state {
 	HTTP_SERVER_STOPPED,    /**< Server not running */
 	HTTP_SERVER_STARTING,   /**< Server starting */
 	HTTP_SERVER_RUNNING,    /**< Server running */
+	HTTP_SERVER_STOPPING,   /**< Stop requested, thread shutting down */
 	HTTP_SERVER_FAILED      /**< Server failed */
 };
 
+/**
+ * @brief Client connection state
+ */
+enum http_conn_state {
+	HTTP_CONN_FREE,         /**< Slot unused */
+	HTTP_CONN_READING,      /**< Receiving request */
+	HTTP_CONN_WRITING,      /**< Sending response */
+	HTTP_CONN_WEBSOCKET,    /**< Upgraded to a WebSocket */
+	HTTP_CONN_EVENTS        /**< Subscribed to the /events stream */
+};
+
+/**
+ * @brief Response being generated on a connection
+ */
+enum http_resp_kind {
+	HTTP_RESP_NONE,         /**< No response pending */
+	HTTP_RESP_CONFIG_PAGE,  /**< Configuration page with scan results */
+	HTTP_RESP_ASSET,        /**< Compressed static asset (or 304) */
+	HTTP_RESP_ERROR,        /**< Error status with plain-text reason */
+	HTTP_RESP_WS_UPGRADE,   /**< 101 Switching Protocols to WebSocket */
+	HTTP_RESP_EVENTS,       /**< Start of a text/event-stream */
+
+	/* JSON API responses, streamed with chunked transfer coding */
+	HTTP_RESP_API_STATUS,   /**< GET /api/v1/status */
+	HTTP_RESP_API_SCAN,     /**< GET /api/v1/scan */
+	HTTP_RESP_API_SETTINGS, /**< GET /api/v1/settings */
+	HTTP_RESP_API_ACCEPTED, /**< POST /api/v1/connect accepted */
+	HTTP_RESP_API_JSON,     /**< Document from a route's render callback */
+	HTTP_RESP_API_ERROR     /**< Error status as a JSON object */
+};
+
+/**
+ * @brief JSON body generator for routes registered outside the server
+ *
+ * Called once per fragment until it returns false. Each call encodes one
+ * piece of the document (for example one list element) into @p w, which
+ * covers a small scratch buffer, so documents of any size can be sent.
+ * The writer starts without a pending comma; list elements other than
+ * the first re-initialize it with json_writer_init(w, w->buf, w->size, true).
+ *
+ * @param w Writer for this fragment
+ * @param index 0 on the first call, incremented after each call
+ * @return true if a fragment was written, false once the document is done
+ */
+typedef bool (*http_json_render_t)(struct json_writer *w, size_t index);
+
+/**
+ * @brief Per-client connection context
+ *
+ * Each slot is a small state machine driven by the server's poll() loop:
+ * the request is accumulated in rx_buf, then the response is produced in
+ * segment-sized batches of fragments so that a slow reader never blocks
+ * other clients.
+ * Persistent connections return to HTTP_CONN_READING after each response
+ * and may already hold the next pipelined request.
+ */
+struct http_conn {
+	int sock;
+	enum http_conn_state state;
+	char rx_buf[HTTP_SERVER_RX_BUF_SIZE];
+	size_t rx_len;
+	struct http_parser parser;  /**< Incremental parser over rx_buf */
+	size_t req_len;         /**< Length of the request being served */
+	bool keep_alive;        /**< Keep connection open after response */
+	uint32_t requests;      /**< Requests served on this connection */
+	int64_t last_activity;  /**< Uptime of last successful I/O (ms) */
+	int64_t req_deadline;   /**< Uptime the request must be complete by (ms), 0 if none started */
+	int64_t last_tx;        /**< Uptime of the last send progress, or since data has been pending (ms) */
+
+	/* Response generator */
+	uint16_t status;
+	enum http_resp_kind resp;
+	const struct web_asset *asset;  /**< Asset for HTTP_RESP_ASSET */
+	bool creds_reply;       /**< Response acknowledges new credentials */
+	const char *allow;      /**< Allow header value for 405 responses */
+	uint32_t api_gen;       /**< Scanner generation an API list started at */
+	http_json_render_t json_render;  /**< Generator for HTTP_RESP_API_JSON */
+	int resp_stage;
+	size_t resp_index;
+
+	/* Batch being sent: static fragments by reference, dynamic ones in tx_buf */
+	struct iovec tx_iov[HTTP_SERVER_TX_IOV_MAX];
+	int tx_iov_cnt;
+	int tx_iov_idx;         /**< First fragment not yet fully sent */
+	size_t tx_scratch_len;  /**< Bytes of tx_buf used by this batch */
+	bool tx_chunked;        /**< Body uses chunked transfer coding */
+	bool tx_chunk_end;      /**< Last chunk has been queued */
+	bool tx_failed;         /**< Body cut short; close once the batch is out */
+	bool tx_head;           /**< Answering HEAD: header only, no body */
+
+	/* WebSocket and event streams: outgoing messages are queued in tx_buf */
+	size_t tx_queue_len;    /**< Queued bytes not yet sent */
+	bool close_after_flush; /**< Drop the connection once the queue drains */
+	char tx_buf[HTTP_SERVER_TX_BUF_SIZE];
+};
+
 /**
  * @brief Credentials submission callback
  *
@@ -44,6 +193,107 @@ typedef void (*http_server_creds_cb_t)(const char *ssid,
                                         const char *password,
                                         void *user_data);
 
+/**
+ * @brief Stored settings reported by the JSON API
+ */
+struct http_server_settings {
+	char ssid[33];          /**< Saved network, empty if none */
+};
+
+/**
+ * @brief Settings query callback
+ *
+ * Called from the server thread to fill in the stored settings for
+ * GET /api/v1/settings. Secrets must not be reported.
+ *
+ * @param settings Settings to fill in (zeroed before the call)
+ * @param user_data User data pointer
+ */
+typedef void (*http_server_settings_cb_t)(struct http_server_settings *settings,
+                                          void *user_data);
+
+/**
+ * @brief Events published on the /events stream
+ */
+enum http_event_type {
+	HTTP_EVENT_SCAN_STARTED,    /**< Network scan began */
+	HTTP_EVENT_SCAN_RESULT,     /**< One network found (ssid, rssi, ...) */
+	HTTP_EVENT_SCAN_DONE,       /**< Scan finished with status */
+	HTTP_EVENT_WIFI_CONNECTING, /**< Connecting to ssid */
+	HTTP_EVENT_WIFI_CONNECTED,  /**< Connected to ssid */
+	HTTP_EVENT_WIFI_FAILED,     /**< Connection to ssid failed with status */
+	HTTP_EVENT_WIFI_DISCONNECTED /**< Link lost */
+};
+
+/**
+ * @brief Event queued for Server-Sent Events subscribers
+ *
+ * Fields not used by an event type are ignored.
+ */
+struct http_event {
+	uint8_t type;           /**< enum http_event_type */
+	int8_t rssi;
+	uint8_t channel;
+	uint8_t security;       /**< enum wifi_security_type */
+	int32_t status;
+	char ssid[33];
+};
+
+/**
+ * @brief Jog command received over the WebSocket
+ */
+struct http_server_jog {
+	int16_t velocity;       /**< Signed speed; 0 stops motion */
+	uint16_t duration_ms;   /**< Run time, 0 = until the next command */
+};
+
+/**
+ * @brief Jog command callback
+ *
+ * Called from the server thread as soon as a command frame arrives, so it
+ * must not block.
+ *
+ * @param jog Decoded command
+ * @param user_data User data pointer
+ */
+typedef void (*http_server_jog_cb_t)(const struct http_server_jog *jog,
+                                     void *user_data);
+
+/**
+ * @brief Application state pushed to WebSocket clients
+ */
+struct http_server_telemetry {
+	int32_t position;       /**< Carriage position in motor steps */
+};
+
+/**
+ * @brief Telemetry query callback
+ *
+ * Called from the server thread once per push interval while WebSocket
+ * clients are connected. Must not block.
+ *
+ * @param telemetry Telemetry to fill in (zeroed before the call)
+ * @param user_data User data pointer
+ */
+typedef void (*http_server_telemetry_cb_t)(struct http_server_telemetry *telemetry,
+                                           void *user_data);
+
+/**
+ * @brief Connection eviction counters
+ *
+ * Counted since http_server_init().
+ */
+struct http_server_stats {
+	uint32_t idle_closed;       /**< Idle keep-alive connections timed out */
+	uint32_t idle_evicted;      /**< Idle connections closed to free a slot */
+	uint32_t request_timeouts;  /**< Requests not received in time (408) */
+	uint32_t send_timeouts;     /**< Clients that stopped reading */
+	uint32_t oversize;          /**< Requests rejected with 413 or 431 */
+	uint32_t refused;           /**< Connections refused, all slots busy */
+	uint32_t responses;         /**< HTTP responses started */
+	uint32_t response_sends;    /**< sendmsg() calls made for HTTP responses */
+};
+
 /**
  * @brief HTTP server context
  */
@@ -53,11 +303,77 @@ struct http_server {
 	struct k_thread server_thread;
 	k_tid_t server_tid;
 	http_server_creds_cb_t creds_cb;
+	http_server_settings_cb_t settings_cb;
+	http_server_jog_cb_t jog_cb;
+	http_server_telemetry_cb_t telemetry_cb;
 	void *cb_user_data;
 	struct wifi_scanner *scanner;  /**< Reference to WiFi scanner */
 	bool running;
+	struct http_conn conns[HTTP_SERVER_MAX_CONNECTIONS];
+	struct http_server_stats stats;
+
+	int64_t ws_next_push;   /**< Uptime of the next telemetry push (ms) */
+
+	/* Events from other threads, fanned out to /events subscribers */
+	struct k_msgq event_q;
+	char event_q_buf[HTTP_SERVER_EVENT_QUEUE_LEN * sizeof(struct http_event)];
+	int wake_fd;            /**< Wakes poll() for queued events and stop */
+	struct k_spinlock wake_lock;  /**< Orders wake_fd writes against its close */
+	int64_t sse_next_ping;  /**< Uptime of the next keep-alive comment (ms) */
+
+	/* Network list rendered for the current scanner generation */
+	char scan_html[HTTP_SERVER_SCAN_CACHE_SIZE];
+	size_t scan_html_len;
+	uint32_t scan_html_gen;
+	bool scan_html_valid;
+
+	/* Credentials parsed from a POST, delivered once the reply is sent */
+	bool creds_pending;
+	char creds_ssid[33];
+	char creds_password[65];
 };
 
+/**
+ * @brief Request handler for a registered route
+ *
+ * Called on the server thread once the request, including its body, has
+ * been received. The handler must start a response with
+ * http_server_respond() before returning.
+ *
+ * @param server HTTP server context
+ * @param conn Connection carrying the request (conn->parser, conn->rx_buf)
+ */
+typedef void (*http_route_handler_t)(struct http_server *server,
+                                     struct http_conn *conn);
+
+/**
+ * @brief Endpoint registered with HTTP_ROUTE_DEFINE()
+ */
+struct http_route {
+	const char *path;       /**< Exact path, without query string */
+	enum http_method method;
+	http_route_handler_t handler;
+};
+
+/**
+ * @brief Register an endpoint at build time
+ *
+ * Routes may be defined in any module; the server collects them from a
+ * linker section, so adding one does not touch http_server.c. Requests
+ * whose path matches but whose method does not are answered with 405.
+ *
+ * @param _name Unique identifier for the route
+ * @param _method enum http_method to match
+ * @param _path Path to match, e.g. "/api/v1/status"
+ * @param _handler http_route_handler_t called for matching requests
+ */
+#define HTTP_ROUTE_DEFINE(_name, _method, _path, _handler)              \
+	static const STRUCT_SECTION_ITERABLE(http_route, _name) = {     \
+		.path = (_path),                                        \
+		.method = (_method),                                    \
+		.handler = (_handler),                                  \
+	}
+
 /**
  * @brief Initialize the HTTP server
  *
@@ -81,11 +397,95 @@ int http_server_start(struct http_server *server,
                        http_server_creds_cb_t creds_cb,
                        void *user_data);
 
+/**
+ * @brief Register the settings query callback for the JSON API
+ *
+ * Must be called before http_server_start(). The callback receives the
+ * user data passed to http_server_start().
+ *
+ * @param server Pointer to HTTP server context
+ * @param settings_cb Callback reporting stored settings
+ */
+void http_server_set_settings_cb(struct http_server *server,
+                                 http_server_settings_cb_t settings_cb);
+
+/**
+ * @brief Register the WebSocket callbacks
+ *
+ * Must be called before http_server_start(). Either callback may be NULL.
+ * The callbacks receive the user data passed to http_server_start().
+ *
+ * @param server Pointer to HTTP server context
+ * @param jog_cb Callback for jog commands
+ * @param telemetry_cb Callback supplying application telemetry
+ */
+void http_server_set_ws_callbacks(struct http_server *server,
+                                  http_server_jog_cb_t jog_cb,
+                                  http_server_telemetry_cb_t telemetry_cb);
+
+/**
+ * @brief Start the response to a request
+ *
+ * For use by route handlers. The body is produced by the server according
+ * to @p resp; error kinds carry only the status reason.
+ *
+ * @param server Pointer to HTTP server context
+ * @param conn Connection passed to the handler
+ * @param status HTTP status code
+ * @param resp Response body kind
+ */
+void http_server_respond(struct http_server *server, struct http_conn *conn,
+                         uint16_t status, enum http_resp_kind resp);
+
+/**
+ * @brief Start a JSON response produced by a render callback
+ *
+ * For use by route handlers. The document is streamed with chunked
+ * transfer coding like the built-in API responses.
+ *
+ * @param server Pointer to HTTP server context
+ * @param conn Connection passed to the handler
+ * @param status HTTP status code
+ * @param render Fragment generator
+ */
+void http_server_respond_json(struct http_server *server, struct http_conn *conn,
+                              uint16_t status, http_json_render_t render);
+
+/**
+ * @brief Publish an event to /events subscribers
+ *
+ * Safe to call from any thread, including network management callbacks.
+ * The event is copied and never blocks the caller; it is dropped if the
+ * server is not running or the queue is full.
+ *
+ * @param server Pointer to HTTP server context
+ * @param event Event to publish
+ * @return 0 on success, -ENODEV if the server is not running, -ENOBUFS
+ *         if the queue is full
+ */
+int http_server_post_event(struct http_server *server,
+                           const struct http_event *event);
+
+/**
+ * @brief Get the connection eviction and response counters
+ *
+ * @param server Pointer to HTTP server context
+ * @param stats Output counters
+ */
+void http_server_get_stats(const struct http_server *server,
+                           struct http_server_stats *stats);
+
 /**
  * @brief Stop the HTTP server
  *
+ * Wakes the server loop and waits for its thread to exit, which takes
+ * well under a poll interval. When called on the server thread itself,
+ * for example from the credentials callback, the stop is only requested:
+ * the thread exits as soon as the callback returns.
+ *
  * @param server Pointer to HTTP server context
- * @return 0 on success, negative errno on failure
+ * @return 0 on success, -EALREADY if not running, -ETIMEDOUT if the
+ *         thread did not exit in time
  */
 int http_server_stop(struct http_server *server);
 
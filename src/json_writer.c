@@ -0,0 +1,172 @@
+/**
+ * @file json_writer.c
+ * @brief Fixed-buffer streaming JSON encoder implementation
+ */
+
+#include "json_writer.h"
+#include <string.h>
+
+/**
+ * @brief Append raw bytes, counting (but dropping) what does not fit
+ */
+static void json_put(struct json_writer *w, const char *s, size_t len)
+{
+	if (w->len + 1 < w->size) {
+		size_t n = MIN(len, w->size - 1 - w->len);
+
+		memcpy(w->buf + w->len, s, n);
+		w->buf[w->len + n] = '\0';
+	}
+
+	w->len += len;
+}
+
+static void json_put_str(struct json_writer *w, const char *s)
+{
+	json_put(w, s, strlen(s));
+}
+
+/**
+ * @brief Append a quoted, escaped string
+ */
+static void json_put_quoted(struct json_writer *w, const char *s)
+{
+	static const char hex[] = "0123456789abcdef";
+
+	json_put(w, "\"", 1);
+
+	while (*s) {
+		const char *run = s;
+
+		/* Copy unescaped runs in one go */
+		while (*s && *s != '"' && *s != '\\' && (unsigned char)*s >= 0x20) {
+			s++;
+		}
+		json_put(w, run, s - run);
+
+		if (!*s) {
+			break;
+		}
+
+		switch (*s) {
+		case '"':
+			json_put(w, "\\\"", 2);
+			break;
+		case '\\':
+			json_put(w, "\\\\", 2);
+			break;
+		case '\n':
+			json_put(w, "\\n", 2);
+			break;
+		case '\r':
+			json_put(w, "\\r", 2);
+			break;
+		case '\t':
+			json_put(w, "\\t", 2);
+			break;
+		default: {
+			char esc[6] = { '\\', 'u', '0', '0',
+			                hex[(*s >> 4) & 0xf], hex[*s & 0xf] };
+
+			json_put(w, esc, sizeof(esc));
+			break;
+		}
+		}
+		s++;
+	}
+
+	json_put(w, "\"", 1);
+}
+
+/**
+ * @brief Emit the separator and member name that precede a value
+ */
+static void json_begin_value(struct json_writer *w, const char *key)
+{
+	if (w->comma) {
+		json_put(w, ",", 1);
+	}
+
+	if (key) {
+		json_put_quoted(w, key);
+		json_put(w, ":", 1);
+	}
+
+	w->comma = true;
+}
+
+void json_writer_init(struct json_writer *w, char *buf, size_t size, bool comma)
+{
+	w->buf = buf;
+	w->size = size;
+	w->len = 0;
+	w->comma = comma;
+
+	if (size > 0) {
+		buf[0] = '\0';
+	}
+}
+
+void json_writer_object_start(struct json_writer *w, const char *key)
+{
+	json_begin_value(w, key);
+	json_put(w, "{", 1);
+	w->comma = false;
+}
+
+void json_writer_object_end(struct json_writer *w)
+{
+	json_put(w, "}", 1);
+	w->comma = true;
+}
+
+void json_writer_array_start(struct json_writer *w, const char *key)
+{
+	json_begin_value(w, key);
+	json_put(w, "[", 1);
+	w->comma = false;
+}
+
+void json_writer_array_end(struct json_writer *w)
+{
+	json_put(w, "]", 1);
+	w->comma = true;
+}
+
+void json_writer_string(struct json_writer *w, const char *key, const char *value)
+{
+	json_begin_value(w, key);
+	json_put_quoted(w, value);
+}
+
+void json_writer_int(struct json_writer *w, const char *key, int64_t value)
+{
+	/* Formatted by hand: printf long long support is optional in Zephyr */
+	char num[21];
+	char *p = num + sizeof(num);
+	uint64_t mag = (value < 0) ? -(uint64_t)value : (uint64_t)value;
+
+	do {
+		*--p = '0' + (mag % 10);
+		mag /= 10;
+	} while (mag);
+
+	if (value < 0) {
+		*--p = '-';
+	}
+
+	json_begin_value(w, key);
+	json_put(w, p, num + sizeof(num) - p);
+}
+
+void json_writer_bool(struct json_writer *w, const char *key, bool value)
+{
+	json_begin_value(w, key);
+	json_put_str(w, value ? "true" : "false");
+}
+
+void json_writer_null(struct json_writer *w, const char *key)
+{
+	json_begin_value(w, key);
+	json_put_str(w, "null");
+}
@@ -0,0 +1,123 @@
+/**
+ * @file json_writer.h
+ * @brief Fixed-buffer streaming JSON encoder
+ *
+ * This module emits JSON text into a caller-supplied buffer, one piece
+ * at a time, without building a document tree. Large documents are
+ * produced as a sequence of small fragments (for example one array
+ * element per call), each encoded into a short scratch buffer and handed
+ * to the socket before the next one is written.
+ *
+ * Like snprintf(), the writer keeps counting once the buffer is full so
+ * callers can tell a truncated fragment from a complete one.
+ */
+
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief JSON encoder state
+ */
+struct json_writer {
+	char *buf;              /**< Output buffer */
+	size_t size;            /**< Size of buf */
+	size_t len;             /**< Bytes produced, may exceed size */
+	bool comma;             /**< Next value must be preceded by a comma */
+};
+
+/**
+ * @brief Start encoding into a buffer
+ *
+ * @param w Pointer to writer
+ * @param buf Output buffer, kept NUL-terminated
+ * @param size Size of buf
+ * @param comma true if the first value continues an open object or array
+ */
+void json_writer_init(struct json_writer *w, char *buf, size_t size, bool comma);
+
+/**
+ * @brief Open an object
+ *
+ * @param w Pointer to writer
+ * @param key Member name, or NULL for a top-level value or array element
+ */
+void json_writer_object_start(struct json_writer *w, const char *key);
+
+/**
+ * @brief Close the innermost object
+ *
+ * @param w Pointer to writer
+ */
+void json_writer_object_end(struct json_writer *w);
+
+/**
+ * @brief Open an array
+ *
+ * @param w Pointer to writer
+ * @param key Member name, or NULL for a top-level value or array element
+ */
+void json_writer_array_start(struct json_writer *w, const char *key);
+
+/**
+ * @brief Close the innermost array
+ *
+ * @param w Pointer to writer
+ */
+void json_writer_array_end(struct json_writer *w);
+
+/**
+ * @brief Emit a string value, escaping it as needed
+ *
+ * @param w Pointer to writer
+ * @param key Member name, or NULL for an array element
+ * @param value NUL-terminated string
+ */
+void json_writer_string(struct json_writer *w, const char *key, const char *value);
+
+/**
+ * @brief Emit an integer value
+ *
+ * @param w Pointer to writer
+ * @param key Member name, or NULL for an array element
+ * @param value Value to encode
+ */
+void json_writer_int(struct json_writer *w, const char *key, int64_t value);
+
+/**
+ * @brief Emit a boolean value
+ *
+ * @param w Pointer to writer
+ * @param key Member name, or NULL for an array element
+ * @param value Value to encode
+ */
+void json_writer_bool(struct json_writer *w, const char *key, bool value);
+
+/**
+ * @brief Emit a null value
+ *
+ * @param w Pointer to writer
+ * @param key Member name, or NULL for an array element
+ */
+void json_writer_null(struct json_writer *w, const char *key);
+
+/**
+ * @brief Get the length of the encoded text
+ *
+ * @param w Pointer to writer
+ * @return Bytes produced; a value >= the buffer size means the output
+ *         was truncated
+ */
+static inline size_t json_writer_len(const struct json_writer *w)
+{
+	return w->len;
+}
+
+#ifdef __cplusplus
+}
+#endif
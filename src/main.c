@@ -7,6 +7,10 @@
  * - Boot counter that increments on each reboot
  * - WiFi credential storage (SSID and password)
  * - Automatic WiFi connection on boot if credentials are stored
+ * - Fast reconnect to the last access point and channel, without a scan
+ * - Several stored networks, tried in order of likely success
+ * - Automatic reconnection with backoff after the link is lost
+ * - Cached DHCP lease reused on rejoin, or an optional static address
  * - WiFi network scanning
  * - AP provisioning mode with HTTP configuration interface
  * - GUI framework for display-based configuration
@@ -22,6 +26,9 @@
  *   wifi_ext scan             - Scan for available networks
  *   wifi_ext provision        - Start AP provisioning mode
  *   demo show                 - Display current settings
+ *   demo http_restart [n]     - Benchmark HTTP server stop/restart latency
+ *   demo http_load [c] [n]    - Benchmark HTTP throughput with c clients
+ *   perf boot                 - Show boot phase timings of recent boots
  *   kernel reboot             - Reboot to test persistence
  */
 
@@ -36,14 +43,21 @@
 #include <zephyr/net/net_mgmt.h>
 #include <zephyr/net/wifi_mgmt.h>
 #include <zephyr/net/net_ip.h>
+#include <stdlib.h>
 #include <string.h>
 
 /* WiFi configuration modules */
 #include "wifi_scanner.h"
 #include "wifi_ap_provisioning.h"
 #include "http_server.h"
+#include "http_load.h"
 #include "wifi_config_gui.h"
 #include "wifi_shell_commands.h"
+#include "wifi_handoff.h"
+#include "boot_profiler.h"
+#include "wifi_profiles.h"
+#include "wifi_supervisor.h"
+#include "wifi_lease.h"
 
 #define STORAGE_PARTITION_ID FIXED_PARTITION_ID(storage_partition)
 
@@ -57,21 +71,65 @@ static char wifi_ssid[WIFI_SSID_MAX + 1] = "";
 static char wifi_psk[WIFI_PSK_MAX + 1] = "";
 static bool wifi_credentials_set = false;
 
+/* Set once the credentials above have been copied into a profile */
+static uint8_t wifi_profiles_migrated;
+
+/*
+ * Access point of the last successful association. Reconnects first ask
+ * for this BSSID on this channel, which spares the driver a scan of
+ * every channel. The SSID ties the record to the credentials it was
+ * learned with; it is ignored once the SSID changes.
+ */
+struct wifi_fast_connect {
+    char ssid[WIFI_SSID_MAX + 1];
+    uint8_t bssid[WIFI_MAC_ADDR_LEN];
+    uint8_t channel;
+    uint8_t band;
+    uint8_t security;
+};
+static struct wifi_fast_connect wifi_fast;
+
 /* WiFi connection state */
 static struct net_mgmt_event_callback wifi_cb;
+static struct net_mgmt_event_callback iface_cb;
+static struct net_mgmt_event_callback ipv4_cb;
 static bool wifi_connected = false;
-static K_SEM_DEFINE(wifi_connected_sem, 0, 1);
+
+/*
+ * Network milestones the boot flow waits on, set from net_mgmt callbacks.
+ * Each wait has its own timeout instead of a fixed sleep.
+ */
+#define NET_EVT_IF_UP           BIT(0)
+#define NET_EVT_CONNECTED       BIT(1)
+#define NET_EVT_CONNECT_FAILED  BIT(2)
+#define NET_EVT_IPV4_READY      BIT(3)
+#define NET_EVT_DISCONNECTED    BIT(4)
+static K_EVENT_DEFINE(net_events);
+
+#define IF_UP_TIMEOUT_MS        5000
+#define WIFI_CONNECT_TIMEOUT_MS 30000
+#define WIFI_FAST_CONNECT_TIMEOUT_MS 5000
+#define WIFI_DISCONNECT_TIMEOUT_MS 2000
+#define WIFI_FAST_PROBE_TIMEOUT_MS 2000
+#define PROFILE_SCAN_TIMEOUT_MS 10000
+#define PROVISION_SCAN_MAX_AGE_MS 60000 /* Older results are rescanned */
+#define IPV4_TIMEOUT_MS         10000
 
 /* WiFi configuration system components */
 static struct wifi_scanner scanner;
 static struct wifi_ap_provisioning ap_prov;
 static struct http_server http_srv;
+static struct wifi_handoff handoff;
+static struct wifi_supervisor supervisor;
 static bool provisioning_mode = false;
+static int provisioning_slot = -ENOENT;
 
 /* Forward declarations */
 static void provisioning_creds_received(const char *ssid,
                                          const char *password,
                                          void *user_data);
+static void http_settings_query(struct http_server_settings *settings,
+                                void *user_data);
 static void start_http_server(void);
 
 /*
@@ -121,6 +179,25 @@ static int demo_handle_set(const char *name, size_t len,
         return rc;
     }
 
+    if (strcmp(name, "profiles_migrated") == 0) {
+        rc = read_cb(cb_arg, &wifi_profiles_migrated, sizeof(wifi_profiles_migrated));
+        return rc < 0 ? rc : 0;
+    }
+
+    if (strcmp(name, "wifi_fast") == 0) {
+        if (len != sizeof(wifi_fast)) {
+            /* Layout changed; relearned on the next connect */
+            return 0;
+        }
+        rc = read_cb(cb_arg, &wifi_fast, sizeof(wifi_fast));
+        if (rc >= 0) {
+            wifi_fast.ssid[WIFI_SSID_MAX] = '\0';
+            printk("Loaded fast reconnect target (channel %u)\n", wifi_fast.channel);
+            return 0;
+        }
+        return rc;
+    }
+
     return -ENOENT;
 }
 
@@ -151,6 +228,15 @@ static int demo_handle_export(int (*cb)(const char *name,
         (void)cb("demo/wifi_psk", wifi_psk, strlen(wifi_psk));
     }
 
+    if (wifi_fast.channel != 0) {
+        (void)cb("demo/wifi_fast", &wifi_fast, sizeof(wifi_fast));
+    }
+
+    if (wifi_profiles_migrated) {
+        (void)cb("demo/profiles_migrated", &wifi_profiles_migrated,
+                 sizeof(wifi_profiles_migrated));
+    }
+
     return 0;
 }
 
@@ -161,6 +247,22 @@ SETTINGS_STATIC_HANDLER_DEFINE(demo_handler, "demo",
                                demo_handle_commit,   /* h_commit */
                                demo_handle_export);  /* h_export */
 
+/*
+ * Publish a connection state change to /events subscribers
+ */
+static void wifi_post_event(enum http_event_type type, int status)
+{
+    struct http_event event = {
+        .type = type,
+        .status = status,
+    };
+
+    strncpy(event.ssid, wifi_ssid, sizeof(event.ssid) - 1);
+
+    /* Dropped when the HTTP server is not running */
+    (void)http_server_post_event(&http_srv, &event);
+}
+
 /*
  * WiFi event handler
  */
@@ -174,27 +276,304 @@ static void wifi_mgmt_event_handler(struct net_mgmt_event_callback *cb,
         if (status->status == 0) {
             wifi_connected = true;
             printk("Connected\n");
+            wifi_post_event(HTTP_EVENT_WIFI_CONNECTED, 0);
+            k_event_post(&net_events, NET_EVT_CONNECTED);
         } else {
             printk("Connection failed (status: %d)\n", status->status);
+            wifi_post_event(HTTP_EVENT_WIFI_FAILED, status->status);
+            k_event_post(&net_events, NET_EVT_CONNECT_FAILED);
         }
-        k_sem_give(&wifi_connected_sem);
+        wifi_supervisor_connect_result(&supervisor, status->status);
         break;
     case NET_EVENT_WIFI_DISCONNECT_RESULT:
         wifi_connected = false;
         printk("Disconnected\n");
+        wifi_post_event(HTTP_EVENT_WIFI_DISCONNECTED, 0);
+        k_event_post(&net_events, NET_EVT_DISCONNECTED);
+        wifi_supervisor_link_down(&supervisor);
         break;
     default:
         break;
     }
 }
 
+/*
+ * Interface and IPv4 event handler
+ */
+static void net_iface_event_handler(struct net_mgmt_event_callback *cb,
+                                    uint64_t mgmt_event, struct net_if *iface)
+{
+    switch (mgmt_event) {
+    case NET_EVENT_IF_UP:
+        k_event_post(&net_events, NET_EVT_IF_UP);
+        break;
+    case NET_EVENT_IF_DOWN:
+        k_event_clear(&net_events, NET_EVT_IF_UP);
+        break;
+    case NET_EVENT_IPV4_DHCP_BOUND:
+        wifi_lease_bound(iface);
+        k_event_post(&net_events, NET_EVT_IPV4_READY);
+        break;
+    case NET_EVENT_IPV4_ADDR_ADD:
+        k_event_post(&net_events, NET_EVT_IPV4_READY);
+        break;
+    case NET_EVENT_IPV4_DHCP_STOP:
+        wifi_lease_withdraw(iface, false);
+        break;
+    case NET_EVENT_IPV4_ACD_FAILED:
+        wifi_lease_withdraw(iface, true);
+        break;
+    default:
+        break;
+    }
+}
+
+/*
+ * Get the interface's preferred IPv4 address, if it has one
+ */
+static struct in_addr *wifi_ipv4_addr(struct net_if *iface)
+{
+    if (iface && iface->config.ip.ipv4 &&
+        iface->config.ip.ipv4->unicast[0].ipv4.addr_state == NET_ADDR_PREFERRED) {
+        return &iface->config.ip.ipv4->unicast[0].ipv4.address.in_addr;
+    }
+
+    return NULL;
+}
+
+/*
+ * Wait for a network milestone
+ *
+ * Returns true if it was reached within timeout_ms.
+ */
+static bool net_wait(uint32_t events, uint32_t timeout_ms, const char *what)
+{
+    int64_t start = k_uptime_get();
+    uint32_t got = k_event_wait(&net_events, events, false, K_MSEC(timeout_ms));
+
+    if (!got) {
+        printk("Timed out after %u ms waiting for %s\n", timeout_ms, what);
+        return false;
+    }
+
+    printk("%s after %u ms (uptime %u ms)\n", what,
+           (uint32_t)(k_uptime_get() - start), k_uptime_get_32());
+    return true;
+}
+
+/*
+ * Check whether the fast reconnect record matches the stored SSID
+ */
+static bool wifi_fast_valid(void)
+{
+    return wifi_fast.channel != 0 && strcmp(wifi_fast.ssid, wifi_ssid) == 0;
+}
+
+/*
+ * Remember the access point just joined, saving it only if it changed
+ */
+static void wifi_fast_learn(struct net_if *iface)
+{
+    struct wifi_iface_status status = {0};
+    struct wifi_fast_connect fast = {0};
+    int rc;
+
+    rc = net_mgmt(NET_REQUEST_WIFI_IFACE_STATUS, iface, &status, sizeof(status));
+    if (rc || status.channel == 0 || status.channel > UINT8_MAX) {
+        return;
+    }
+
+    strncpy(fast.ssid, wifi_ssid, WIFI_SSID_MAX);
+    memcpy(fast.bssid, status.bssid, sizeof(fast.bssid));
+    fast.channel = status.channel;
+    fast.band = status.band;
+    fast.security = status.security;
+
+    if (memcmp(&fast, &wifi_fast, sizeof(fast)) == 0) {
+        return;
+    }
+
+    wifi_fast = fast;
+    rc = settings_save_one("demo/wifi_fast", &wifi_fast, sizeof(wifi_fast));
+    if (rc) {
+        printk("Warning: Failed to save fast reconnect target: %d\n", rc);
+    }
+}
+
+/*
+ * Fill connect parameters for the stored credentials
+ *
+ * With fast set, the request targets the learned access point and
+ * channel; the caller checks wifi_fast_valid() first.
+ */
+static void wifi_connect_params(struct wifi_connect_req_params *params, bool fast)
+{
+    memset(params, 0, sizeof(*params));
+    params->ssid = wifi_ssid;
+    params->ssid_length = strlen(wifi_ssid);
+    params->psk = wifi_psk;
+    params->psk_length = strlen(wifi_psk);
+    params->mfp = WIFI_MFP_OPTIONAL;
+
+    if (fast) {
+        params->channel = wifi_fast.channel;
+        params->band = wifi_fast.band;
+        params->security = wifi_fast.security;
+        memcpy(params->bssid, wifi_fast.bssid, sizeof(params->bssid));
+    } else {
+        params->channel = WIFI_CHANNEL_ANY;
+        params->security = (strlen(wifi_psk) > 0) ? WIFI_SECURITY_TYPE_PSK : WIFI_SECURITY_TYPE_NONE;
+        params->band = WIFI_FREQ_BAND_2_4_GHZ;
+    }
+}
+
+/*
+ * Request an association and wait for its result
+ */
+static int wifi_connect_attempt(struct net_if *iface,
+                                struct wifi_connect_req_params *params,
+                                uint32_t timeout_ms)
+{
+    int rc;
+
+    /* Forget results and addresses from any earlier association */
+    k_event_clear(&net_events, NET_EVT_CONNECTED | NET_EVT_CONNECT_FAILED |
+                               NET_EVT_IPV4_READY);
+
+    /* Send connection request - this is asynchronous */
+    rc = net_mgmt(NET_REQUEST_WIFI_CONNECT, iface, params, sizeof(*params));
+    if (rc) {
+        return rc;
+    }
+
+    /* Wait for connection result event */
+    if (!net_wait(NET_EVT_CONNECTED | NET_EVT_CONNECT_FAILED,
+                  timeout_ms, "connect result")) {
+        return -ETIMEDOUT;
+    }
+
+    return wifi_connected ? 0 : -ENOEXEC;
+}
+
+/*
+ * Abandon an association that may still be in progress
+ *
+ * Waits for the driver to confirm, so that its late results are not
+ * taken for those of the next attempt.
+ */
+static void wifi_connect_abandon(struct net_if *iface)
+{
+    k_event_clear(&net_events, NET_EVT_DISCONNECTED);
+
+    /* Refused when there is nothing to abandon; no result follows then */
+    if (net_mgmt(NET_REQUEST_WIFI_DISCONNECT, iface, NULL, 0) == 0) {
+        (void)net_wait(NET_EVT_DISCONNECTED, WIFI_DISCONNECT_TIMEOUT_MS,
+                       "disconnect result");
+    }
+}
+
+/*
+ * Initialize the scanner on first use
+ *
+ * Results published by earlier scans, background ones included, are kept
+ * for later users rather than wiped by another init.
+ */
+static int wifi_scanner_ready(void)
+{
+    static bool initialized;
+    int rc;
+
+    if (initialized) {
+        return 0;
+    }
+
+    rc = wifi_scanner_init(&scanner);
+    if (rc == 0) {
+        initialized = true;
+    }
+    return rc;
+}
+
+/*
+ * Progress of a probe for the fast reconnect target
+ */
+struct wifi_fast_probe {
+    struct k_sem done;
+    size_t found;       /* Access points reported */
+    bool seen;
+    int status;
+};
+
+static void wifi_fast_probe_event(enum wifi_scanner_event event,
+                                  const struct wifi_scan_result *result,
+                                  int status, void *user_data)
+{
+    struct wifi_fast_probe *probe = user_data;
+
+    switch (event) {
+    case WIFI_SCANNER_EVT_RESULT:
+        probe->found++;
+        if (result->channel == wifi_fast.channel &&
+            result->mac_length == WIFI_MAC_ADDR_LEN &&
+            memcmp(result->mac, wifi_fast.bssid, WIFI_MAC_ADDR_LEN) == 0) {
+            probe->seen = true;
+        }
+        break;
+    case WIFI_SCANNER_EVT_DONE:
+        probe->status = status;
+        k_sem_give(&probe->done);
+        break;
+    default:
+        break;
+    }
+}
+
+/*
+ * Check that the last access point is still on its channel
+ *
+ * Probing that one channel takes a fraction of the fast connect timeout,
+ * which is otherwise spent waiting on an access point that has moved or
+ * gone. Only a probe that completed and reported other access points,
+ * but not this one, rules the fast attempt out; an empty probe may just
+ * mean the driver reported nothing, so it proves nothing.
+ */
+static bool wifi_fast_probe(void)
+{
+    struct wifi_fast_probe probe = {0};
+    struct wifi_scan_params params;
+
+    if (wifi_scanner_ready()) {
+        return true;
+    }
+
+    k_sem_init(&probe.done, 0, 1);
+    wifi_scanner_params_probe(&params, wifi_fast.ssid,
+                              (enum wifi_frequency_bands)wifi_fast.band,
+                              wifi_fast.channel);
+
+    if (wifi_scanner_scan_params_async(&scanner, &params, WIFI_FAST_PROBE_TIMEOUT_MS,
+                                       wifi_fast_probe_event, &probe)) {
+        return true;
+    }
+
+    /* The scanner always reports EVT_DONE, at the latest on its timeout */
+    k_sem_take(&probe.done, K_FOREVER);
+
+    return probe.status != 0 || probe.found == 0 || probe.seen;
+}
+
 /*
  * Connect to WiFi using stored credentials
+ *
+ * Tries the access point and channel of the last successful association
+ * first, unless a probe finds it gone from that channel, then falls back
+ * to a connect on any channel.
  */
 static int wifi_connect_stored(void)
 {
     struct net_if *iface = net_if_get_default();
-    struct wifi_connect_req_params params = {0};
+    struct wifi_connect_req_params params;
+    int rc = -ENOENT;
 
     if (!iface) {
         printk("ERROR: No network interface found\n");
@@ -207,29 +586,131 @@ static int wifi_connect_stored(void)
     }
 
     printk("Connecting to WiFi SSID: %s\n", wifi_ssid);
+    wifi_post_event(HTTP_EVENT_WIFI_CONNECTING, 0);
+
+    if (wifi_fast_valid() && !wifi_fast_probe()) {
+        printk("Last access point not on channel %u, scanning all channels\n",
+               wifi_fast.channel);
+    } else if (wifi_fast_valid()) {
+        printk("Trying last access point on channel %u\n", wifi_fast.channel);
 
-    params.ssid = wifi_ssid;
-    params.ssid_length = strlen(wifi_ssid);
-    params.psk = wifi_psk;
-    params.psk_length = strlen(wifi_psk);
-    params.channel = WIFI_CHANNEL_ANY;
-    params.security = (strlen(wifi_psk) > 0) ? WIFI_SECURITY_TYPE_PSK : WIFI_SECURITY_TYPE_NONE;
-    params.band = WIFI_FREQ_BAND_2_4_GHZ;
-    params.mfp = WIFI_MFP_OPTIONAL;
+        wifi_connect_params(&params, true);
+        rc = wifi_connect_attempt(iface, &params, WIFI_FAST_CONNECT_TIMEOUT_MS);
+        if (rc) {
+            printk("Fast reconnect failed (%d), scanning all channels\n", rc);
+            wifi_connect_abandon(iface);
+        }
+    }
 
-    /* Reset semaphore before connecting */
-    k_sem_reset(&wifi_connected_sem);
+    if (rc) {
+        wifi_connect_params(&params, false);
+        rc = wifi_connect_attempt(iface, &params, WIFI_CONNECT_TIMEOUT_MS);
+        if (rc) {
+            return rc;
+        }
+    }
 
-    /* Send connection request - this is asynchronous */
-    net_mgmt(NET_REQUEST_WIFI_CONNECT, iface, &params, sizeof(params));
+    wifi_fast_learn(iface);
+    boot_profiler_mark("wifi_assoc");
 
-    /* Wait for connection result event */
-    if (k_sem_take(&wifi_connected_sem, K_SECONDS(30)) != 0) {
-        printk("Connection timeout\n");
-        return -ETIMEDOUT;
+    /* Static address, or the cached lease while DHCP confirms it */
+    rc = wifi_lease_apply(iface, wifi_ssid);
+    if (rc && rc != -ENOENT) {
+        printk("Warning: Address setup failed: %d\n", rc);
     }
+    return 0;
+}
 
-    return wifi_connected ? 0 : -ENOEXEC;
+/*
+ * Connect to the most promising stored network
+ *
+ * With several profiles, a scan shows which networks are in range and
+ * they are tried best first; networks the scan missed are tried after
+ * them. A single profile is connected directly so the fast reconnect is
+ * not held up by a scan.
+ */
+static int wifi_connect_profiles(void)
+{
+    const struct wifi_scan_snapshot *snap = NULL;
+    uint8_t order[WIFI_PROFILES_MAX];
+    size_t n;
+    int rc;
+
+    if (wifi_profiles_count() > 1) {
+        rc = wifi_scanner_ready();
+        if (rc) {
+            printk("Warning: WiFi scanner init failed: %d\n", rc);
+        }
+
+        rc = wifi_scanner_scan(&scanner, PROFILE_SCAN_TIMEOUT_MS);
+        if (rc == 0) {
+            snap = wifi_scanner_snapshot_get(&scanner);
+        } else {
+            /* Without a scan, every profile is tried on its history */
+            printk("Scan failed (%d), trying all stored networks\n", rc);
+        }
+    }
+
+    n = wifi_profiles_rank(snap, order, ARRAY_SIZE(order));
+    wifi_scanner_snapshot_put(snap);
+    if (n == 0) {
+        printk("No stored networks\n");
+        return -ENOENT;
+    }
+
+    rc = -ENOENT;
+    for (size_t i = 0; i < n; i++) {
+        struct wifi_profile profile;
+        int64_t start;
+
+        if (wifi_profiles_get(order[i], &profile)) {
+            continue;
+        }
+
+        strcpy(wifi_ssid, profile.ssid);
+        strcpy(wifi_psk, profile.psk);
+        wifi_credentials_set = true;
+
+        start = k_uptime_get();
+        rc = wifi_connect_stored();
+        wifi_profiles_report(order[i], rc, (uint32_t)(k_uptime_get() - start));
+        if (rc == 0) {
+            return 0;
+        }
+
+        printk("Could not join '%s': %d\n", profile.ssid, rc);
+    }
+
+    return rc;
+}
+
+/*
+ * Supervisor connect request: issue it and return, the result arrives
+ * through wifi_mgmt_event_handler()
+ */
+static int wifi_reconnect_request(bool fast, void *user_data)
+{
+    struct net_if *iface = net_if_get_default();
+    struct wifi_connect_req_params params;
+
+    ARG_UNUSED(user_data);
+
+    if (!iface) {
+        return -ENODEV;
+    }
+
+    if (strlen(wifi_ssid) == 0 || !wifi_credentials_set) {
+        return -EINVAL;
+    }
+
+    if (fast && !wifi_fast_valid()) {
+        return -ENOENT;
+    }
+
+    wifi_connect_params(&params, fast);
+    wifi_post_event(HTTP_EVENT_WIFI_CONNECTING, 0);
+
+    return net_mgmt(NET_REQUEST_WIFI_CONNECT, iface, &params, sizeof(params));
 }
 
 /*
@@ -259,6 +740,10 @@ static int cmd_wifi_set_ssid(const struct shell *sh, size_t argc, char **argv)
     }
 
     shell_print(sh, "WiFi SSID saved: '%s'", wifi_ssid);
+
+    if (wifi_credentials_set) {
+        (void)wifi_profiles_add(wifi_ssid, wifi_psk);
+    }
     return 0;
 }
 
@@ -290,6 +775,10 @@ static int cmd_wifi_set_password(const struct shell *sh, size_t argc, char **arg
     }
 
     shell_print(sh, "WiFi password saved");
+
+    if (strlen(wifi_ssid) > 0) {
+        (void)wifi_profiles_add(wifi_ssid, wifi_psk);
+    }
     return 0;
 }
 
@@ -306,30 +795,38 @@ static void start_http_server(void)
         return;
     }
 
-    /* Wait for DHCP to complete and get IP address */
-    printk("Waiting for IP address...\n");
-    k_msleep(3000);
+    /* Wait for DHCP (or a static address), unless already assigned */
+    if (!wifi_ipv4_addr(net_if_get_default())) {
+        printk("Waiting for IP address...\n");
+        net_wait(NET_EVT_IPV4_READY, IPV4_TIMEOUT_MS, "IPv4 address");
+    }
+    boot_profiler_mark("dhcp");
 
     /* Start HTTP server for web configuration interface */
     printk("Starting HTTP configuration server...\n");
 
     /* Initialize WiFi scanner if not already done */
-    if (scanner.state == WIFI_SCANNER_IDLE) {
-        rc = wifi_scanner_init(&scanner);
-        if (rc) {
-            printk("Warning: WiFi scanner init failed: %d\n", rc);
-        }
+    rc = wifi_scanner_ready();
+    if (rc) {
+        printk("Warning: WiFi scanner init failed: %d\n", rc);
     }
 
+#ifdef CONFIG_SLIDER_WIFI_BG_SCAN
+    /* Keep the configuration page's network list current */
+    if (rc == 0) {
+        wifi_scanner_set_background(&scanner, CONFIG_SLIDER_WIFI_BG_SCAN_INTERVAL_S * 1000U);
+    }
+#endif
+
     /* Initialize HTTP server */
     rc = http_server_init(&http_srv, &scanner);
     if (rc == 0) {
+        http_server_set_settings_cb(&http_srv, http_settings_query);
         rc = http_server_start(&http_srv, provisioning_creds_received, NULL);
         if (rc == 0) {
-            struct net_if *iface = net_if_get_default();
-            if (iface && iface->config.ip.ipv4 &&
-                iface->config.ip.ipv4->unicast[0].ipv4.addr_state == NET_ADDR_PREFERRED) {
-                struct in_addr *addr = &iface->config.ip.ipv4->unicast[0].ipv4.address.in_addr;
+            boot_profiler_mark("http_ready");
+            struct in_addr *addr = wifi_ipv4_addr(net_if_get_default());
+            if (addr) {
                 printk("\n");
                 printk("===========================================\n");
                 printk("  WiFi Configuration Interface Ready\n");
@@ -378,6 +875,9 @@ static int cmd_wifi_reset(const struct shell *sh, size_t argc, char **argv)
 
     shell_print(sh, "Resetting WiFi credentials...");
 
+    /* Do not reconnect with credentials that are going away */
+    wifi_supervisor_disarm(&supervisor);
+
     /* Clear in-memory variables */
     memset(wifi_ssid, 0, sizeof(wifi_ssid));
     memset(wifi_psk, 0, sizeof(wifi_psk));
@@ -394,6 +894,15 @@ static int cmd_wifi_reset(const struct shell *sh, size_t argc, char **argv)
         shell_error(sh, "Failed to delete password: %d", rc);
     }
 
+    memset(&wifi_fast, 0, sizeof(wifi_fast));
+    rc = settings_delete("demo/wifi_fast");
+    if (rc && rc != -ENOENT) {
+        shell_error(sh, "Failed to delete fast reconnect target: %d", rc);
+    }
+
+    wifi_profiles_clear();
+    wifi_lease_clear();
+
     /* Save to persist deletion */
     rc = settings_save();
     if (rc) {
@@ -411,10 +920,33 @@ static int cmd_wifi_reset(const struct shell *sh, size_t argc, char **argv)
  */
 static int cmd_wifi_status(const struct shell *sh, size_t argc, char **argv)
 {
+    struct wifi_supervisor_stats stats;
+    struct wifi_lease lease;
+    char addr[NET_IPV4_ADDR_LEN];
+
     shell_print(sh, "WiFi Status:");
     shell_print(sh, "  SSID: %s", strlen(wifi_ssid) > 0 ? wifi_ssid : "<not set>");
     shell_print(sh, "  Password: %s", strlen(wifi_psk) > 0 ? "***" : "<not set>");
     shell_print(sh, "  Connected: %s", wifi_connected ? "Yes" : "No");
+
+    if (wifi_lease_get(&lease) == 0) {
+        shell_print(sh, "  Cached lease: %s on '%s', %u s",
+                    net_addr_ntop(AF_INET, &lease.addr, addr, sizeof(addr)),
+                    lease.ssid, lease.lease_s);
+    }
+
+    wifi_supervisor_get_stats(&supervisor, &stats);
+    shell_print(sh, "  Supervisor: %s",
+                wifi_supervisor_state_to_string(wifi_supervisor_get_state(&supervisor)));
+    shell_print(sh, "  Disconnects: %u, recovered: %u (last %u ms, max %u ms)",
+                stats.disconnects, stats.recoveries,
+                stats.last_recover_ms, stats.max_recover_ms);
+    shell_print(sh, "  Reconnect attempts: %u, failed: %u",
+                stats.attempts, stats.failures);
+    shell_print(sh, "  Recovery time  <1s:%u <2s:%u <5s:%u <10s:%u <30s:%u <60s:%u <300s:%u more:%u",
+                stats.recover_hist[0], stats.recover_hist[1], stats.recover_hist[2],
+                stats.recover_hist[3], stats.recover_hist[4], stats.recover_hist[5],
+                stats.recover_hist[6], stats.recover_hist[7]);
     return 0;
 }
 
@@ -428,9 +960,93 @@ static int cmd_show(const struct shell *sh, size_t argc, char **argv)
     shell_print(sh, "  WiFi SSID: %s", strlen(wifi_ssid) > 0 ? wifi_ssid : "<not set>");
     shell_print(sh, "  WiFi Password: %s", strlen(wifi_psk) > 0 ? "***" : "<not set>");
     shell_print(sh, "  WiFi Connected: %s", wifi_connected ? "Yes" : "No");
+    if (wifi_fast_valid()) {
+        shell_print(sh, "  Fast reconnect: %02x:%02x:%02x:%02x:%02x:%02x, channel %u",
+                    wifi_fast.bssid[0], wifi_fast.bssid[1], wifi_fast.bssid[2],
+                    wifi_fast.bssid[3], wifi_fast.bssid[4], wifi_fast.bssid[5],
+                    wifi_fast.channel);
+    } else {
+        shell_print(sh, "  Fast reconnect: <not learned>");
+    }
+    return 0;
+}
+
+/*
+ * Shell command: measure HTTP server stop-to-restart latency
+ */
+static int cmd_http_restart(const struct shell *sh, size_t argc, char **argv)
+{
+    int count = (argc > 1) ? atoi(argv[1]) : 10;
+    uint32_t stop_max = 0, ready_max = 0;
+    uint64_t stop_sum = 0, ready_sum = 0;
+
+    if (count <= 0) {
+        shell_error(sh, "Usage: demo http_restart [count]");
+        return -EINVAL;
+    }
+
+    if (http_srv.state != HTTP_SERVER_RUNNING) {
+        shell_error(sh, "HTTP server is not running");
+        return -ENODEV;
+    }
+
+    for (int i = 0; i < count; i++) {
+        uint32_t start = k_cycle_get_32();
+        uint32_t stop_us, ready_us;
+        int rc;
+
+        rc = http_server_stop(&http_srv);
+        stop_us = k_cyc_to_us_floor32(k_cycle_get_32() - start);
+        if (rc) {
+            shell_error(sh, "Stop failed: %d", rc);
+            return rc;
+        }
+
+        rc = http_server_start(&http_srv, provisioning_creds_received, NULL);
+        if (rc) {
+            shell_error(sh, "Start failed: %d", rc);
+            return rc;
+        }
+
+        /* Ready once the thread is listening again */
+        while (http_srv.state == HTTP_SERVER_STARTING) {
+            k_msleep(1);
+        }
+        ready_us = k_cyc_to_us_floor32(k_cycle_get_32() - start);
+        if (http_srv.state != HTTP_SERVER_RUNNING) {
+            shell_error(sh, "Server failed to restart");
+            return -EIO;
+        }
+
+        stop_sum += stop_us;
+        ready_sum += ready_us;
+        stop_max = MAX(stop_max, stop_us);
+        ready_max = MAX(ready_max, ready_us);
+    }
+
+    shell_print(sh, "HTTP restart x%d:", count);
+    shell_print(sh, "  stop:          avg %u us, max %u us",
+                (uint32_t)(stop_sum / count), stop_max);
+    shell_print(sh, "  stop to ready: avg %u us, max %u us",
+                (uint32_t)(ready_sum / count), ready_max);
     return 0;
 }
 
+/*
+ * Shell command: measure HTTP throughput and latency with concurrent clients
+ *
+ * The clients reach the server through the interface's own address.
+ */
+static int cmd_http_load(const struct shell *sh, size_t argc, char **argv)
+{
+    int clients = (argc > 1) ? atoi(argv[1]) : MIN(4, HTTP_LOAD_MAX_CLIENTS);
+    int requests = (argc > 2) ? atoi(argv[2]) : 20;
+    const char *path = (argc > 3) ? argv[3] : "/";
+
+    return http_load_run(sh, &http_srv, wifi_ipv4_addr(net_if_get_default()),
+                         clients, requests, path);
+}
+
 /* Register WiFi shell commands */
 SHELL_STATIC_SUBCMD_SET_CREATE(wifi_cmds,
     SHELL_CMD(set_ssid, NULL, "Set WiFi SSID", cmd_wifi_set_ssid),
@@ -446,15 +1062,63 @@ SHELL_CMD_REGISTER(wifi, &wifi_cmds, "WiFi commands", NULL);
 /* Register demo shell commands */
 SHELL_STATIC_SUBCMD_SET_CREATE(demo_cmds,
     SHELL_CMD(show, NULL, "Show all settings", cmd_show),
+    SHELL_CMD_ARG(http_restart, NULL, "Benchmark HTTP server stop/restart [count]",
+                  cmd_http_restart, 1, 1),
+    SHELL_CMD_ARG(http_load, NULL, "Benchmark HTTP requests [clients] [requests] [path]",
+                  cmd_http_load, 1, 3),
     SHELL_SUBCMD_SET_END
 );
 
 SHELL_CMD_REGISTER(demo, &demo_cmds, "Settings demo commands", NULL);
 
+/*
+ * Handoff stage: persist the submitted credentials
+ */
+static int provisioning_save(void *user_data)
+{
+	ARG_UNUSED(user_data);
+
+	int rc = settings_save();
+	if (rc) {
+		printk("Warning: Failed to save credentials: %d\n", rc);
+	} else {
+		printk("Credentials saved to flash\n");
+	}
+
+	provisioning_slot = wifi_profiles_add(wifi_ssid, wifi_psk);
+
+	return rc;
+}
+
+/*
+ * Handoff result
+ */
+static void provisioning_done(int status, void *user_data)
+{
+	ARG_UNUSED(user_data);
+
+	provisioning_mode = false;
+
+	if (provisioning_slot >= 0) {
+		wifi_profiles_report(provisioning_slot, status,
+		                     handoff.stage_ms[WIFI_HANDOFF_CONNECTING]);
+	}
+
+	if (status) {
+		printk("Could not join new network: %d (use 'wifi connect' to retry)\n",
+		       status);
+		return;
+	}
+
+	printk("Joined new network in %u ms\n", handoff.total_ms);
+}
+
 /*
  * Provisioning credentials callback
  *
- * Called when user submits WiFi credentials via AP provisioning interface
+ * Called when user submits WiFi credentials via AP provisioning interface.
+ * Runs on the HTTP server thread, so the switch to station mode is only
+ * queued here; see wifi_handoff.h.
  */
 static void provisioning_creds_received(const char *ssid,
                                          const char *password,
@@ -478,27 +1142,26 @@ static void provisioning_creds_received(const char *ssid,
 		wifi_credentials_set = true;
 	}
 
-	/* Save to flash */
-	int rc = settings_save();
+	/* Save, stop provisioning and join the new network */
+	printk("Stopping provisioning mode...\n");
+	int rc = wifi_handoff_start(&handoff, wifi_ssid, wifi_psk,
+	                            provisioning_save, provisioning_done, NULL);
 	if (rc) {
-		printk("Warning: Failed to save credentials: %d\n", rc);
-	} else {
-		printk("Credentials saved to flash\n");
+		printk("Warning: Handoff not started: %d\n", rc);
 	}
+}
 
-	/* Stop provisioning mode */
-	printk("Stopping provisioning mode...\n");
-	http_server_stop(&http_srv);
-	wifi_ap_provisioning_stop(&ap_prov);
-	provisioning_mode = false;
-
-	/* Wait for AP to fully stop before attempting station mode */
-	printk("Waiting for AP to shut down...\n");
-	k_msleep(2000);
+/*
+ * Settings query callback
+ *
+ * Reports stored settings to the HTTP JSON API (never the password)
+ */
+static void http_settings_query(struct http_server_settings *settings,
+                                void *user_data)
+{
+	ARG_UNUSED(user_data);
 
-	/* Try to connect to new network */
-	printk("Attempting to connect to new network...\n");
-	wifi_connect_stored();
+	strncpy(settings->ssid, wifi_ssid, sizeof(settings->ssid) - 1);
 }
 
 /*
@@ -508,6 +1171,8 @@ static void provisioning_creds_received(const char *ssid,
  */
 static int start_provisioning_mode(void)
 {
+	const struct wifi_scan_snapshot *snap;
+	bool cached;
 	int rc;
 
 	if (provisioning_mode) {
@@ -518,29 +1183,42 @@ static int start_provisioning_mode(void)
 	printk("\n=== Entering Provisioning Mode ===\n");
 
 	/* Initialize WiFi scanner */
-	rc = wifi_scanner_init(&scanner);
+	rc = wifi_scanner_ready();
 	if (rc) {
 		printk("ERROR: WiFi scanner init failed: %d\n", rc);
 		return rc;
 	}
 
-	/* Scan for networks to show in web interface */
-	printk("Scanning for WiFi networks...\n");
-	rc = wifi_scanner_scan(&scanner, 10000);
-	if (rc) {
-		printk("Warning: WiFi scan failed: %d\n", rc);
+	/* Scan for networks to show in web interface, unless recent results
+	 * are at hand. This happens before the access point is up, so its
+	 * clients are not left waiting while the radio is off channel.
+	 */
+	snap = wifi_scanner_snapshot_get(&scanner);
+	cached = snap->count > 0 &&
+	         wifi_scanner_snapshot_age_ms(snap) <= PROVISION_SCAN_MAX_AGE_MS;
+	wifi_scanner_snapshot_put(snap);
+
+	if (cached) {
+		printk("Using cached scan results\n");
 	} else {
-		size_t count;
-		wifi_scanner_get_results(&scanner, &count);
-		printk("Found %zu networks\n", count);
+		printk("Scanning for WiFi networks...\n");
+		rc = wifi_scanner_scan(&scanner, 10000);
+		if (rc) {
+			printk("Warning: WiFi scan failed: %d\n", rc);
+		}
 	}
 
+	snap = wifi_scanner_snapshot_get(&scanner);
+	printk("Found %zu networks\n", snap->count);
+	wifi_scanner_snapshot_put(snap);
+
 	/* Initialize HTTP server */
 	rc = http_server_init(&http_srv, &scanner);
 	if (rc) {
 		printk("ERROR: HTTP server init failed: %d\n", rc);
 		return rc;
 	}
+	http_server_set_settings_cb(&http_srv, http_settings_query);
 
 	/* Initialize AP provisioning */
 	rc = wifi_ap_provisioning_init(&ap_prov, NULL);
@@ -576,6 +1254,7 @@ static int start_provisioning_mode(void)
 	}
 
 	provisioning_mode = true;
+	boot_profiler_mark("provisioning");
 
 	printk("\n");
 	printk("===========================================\n");
@@ -598,6 +1277,8 @@ int main(void)
     const struct flash_area *fa;
     const struct device *flash_dev;
 
+    boot_profiler_mark("main");
+
     printk("\n=== Settings Demo ===\n");
     printk("Board: Raspberry Pi Pico W\n\n");
 
@@ -618,6 +1299,7 @@ int main(void)
     printk("Flash storage ready (offset=0x%lx size=0x%lx)\n",
            (unsigned long)fa->fa_off, (unsigned long)fa->fa_size);
     flash_area_close(fa);
+    boot_profiler_mark("flash");
 
     /* Initialize settings subsystem */
     rc = settings_subsys_init();
@@ -625,6 +1307,7 @@ int main(void)
         printk("ERROR: Settings initialization failed: %d\n", rc);
         return rc;
     }
+    boot_profiler_mark("settings_init");
 
     /* Load existing settings from flash */
     rc = settings_load();
@@ -632,6 +1315,22 @@ int main(void)
         printk("Warning: Settings load returned %d\n", rc);
     }
 
+    /*
+     * Credentials stored before profiles existed become the first one.
+     * Only once: later the user may remove that profile on purpose.
+     */
+    if (!wifi_profiles_migrated &&
+        (!wifi_credentials_set || strlen(wifi_ssid) == 0 ||
+         wifi_profiles_add(wifi_ssid, wifi_psk) >= 0)) {
+        wifi_profiles_migrated = 1;
+        rc = settings_save_one("demo/profiles_migrated", &wifi_profiles_migrated,
+                               sizeof(wifi_profiles_migrated));
+        if (rc) {
+            printk("Warning: Failed to save profile migration: %d\n", rc);
+        }
+    }
+    boot_profiler_mark("settings_load");
+
     /* Increment and save boot counter */
     boot_count++;
     printk("\nBoot count: %u\n", boot_count);
@@ -640,6 +1339,10 @@ int main(void)
     if (rc) {
         printk("Warning: Failed to save boot count: %d\n", rc);
     }
+    boot_profiler_mark("bootcnt_save");
+
+    /* Reconnect on its own after the link is lost */
+    wifi_supervisor_init(&supervisor, wifi_reconnect_request, NULL);
 
     /* Initialize WiFi management callbacks */
     net_mgmt_init_event_callback(&wifi_cb, wifi_mgmt_event_handler,
@@ -647,17 +1350,37 @@ int main(void)
                                  NET_EVENT_WIFI_DISCONNECT_RESULT);
     net_mgmt_add_event_callback(&wifi_cb);
 
+    net_mgmt_init_event_callback(&iface_cb, net_iface_event_handler,
+                                 NET_EVENT_IF_UP | NET_EVENT_IF_DOWN);
+    net_mgmt_add_event_callback(&iface_cb);
+
+    net_mgmt_init_event_callback(&ipv4_cb, net_iface_event_handler,
+                                 NET_EVENT_IPV4_DHCP_BOUND |
+                                 NET_EVENT_IPV4_DHCP_STOP |
+                                 NET_EVENT_IPV4_ACD_FAILED |
+                                 NET_EVENT_IPV4_ADDR_ADD);
+    net_mgmt_add_event_callback(&ipv4_cb);
+
+    /* The interface may have come up before the callback was added */
+    if (net_if_get_default() && net_if_is_up(net_if_get_default())) {
+        k_event_post(&net_events, NET_EVT_IF_UP);
+    }
+
+    /* Provisioning to station mode handoff */
+    wifi_handoff_init(&handoff, &http_srv, &ap_prov);
+
     /* Initialize extended WiFi shell commands */
     wifi_shell_commands_init(&scanner, &ap_prov);
 
     /* Auto-connect to WiFi if credentials are stored */
-    if (strlen(wifi_ssid) > 0 && wifi_credentials_set) {
+    if (wifi_profiles_count() > 0) {
         printk("\nAuto-connecting to WiFi...\n");
 
-        /* Wait for WiFi subsystem to be fully ready */
-        k_msleep(2000);
+        /* Wait for the WiFi interface to come up */
+        net_wait(NET_EVT_IF_UP, IF_UP_TIMEOUT_MS, "WiFi interface up");
+        boot_profiler_mark("if_up");
 
-        rc = wifi_connect_stored();
+        rc = wifi_connect_profiles();
         if (rc == 0) {
             printk("Auto-connect successful\n");
             start_http_server();
@@ -676,6 +1399,9 @@ int main(void)
         }
     }
 
+    /* Later connects and restarts are not part of the boot */
+    boot_profiler_finish();
+
     /* Display available commands */
     printk("\nShell commands:\n");
     printk("  wifi set_ssid <ssid>      - Store WiFi SSID\n");
@@ -686,6 +1412,7 @@ int main(void)
     printk("  wifi_ext scan             - Scan for networks\n");
     printk("  wifi_ext provision        - Start provisioning mode\n");
     printk("  demo show                 - Show all settings\n");
+    printk("  perf boot                 - Show boot phase timings\n");
     printk("  kernel reboot             - Test persistence\n\n");
 
     /* Main loop */
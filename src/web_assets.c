@@ -0,0 +1,19 @@
+/**
+ * @file web_assets.c
+ * @brief Build-time compressed web UI asset lookup
+ */
+
+#include "web_assets.h"
+#include <string.h>
+
+const struct web_asset *web_asset_find(const char *path, size_t len)
+{
+	for (size_t i = 0; i < web_assets_count; i++) {
+		if (strlen(web_assets[i].path) == len &&
+		    memcmp(web_assets[i].path, path, len) == 0) {
+			return &web_assets[i];
+		}
+	}
+
+	return NULL;
+}
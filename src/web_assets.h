@@ -0,0 +1,47 @@
+/**
+ * @file web_assets.h
+ * @brief Build-time compressed web UI assets
+ *
+ * The files in web/ are minified and gzip-compressed by the build (see
+ * CMakeLists.txt) into a constant table. Each asset carries a strong ETag
+ * derived from its content, so browsers can revalidate cached copies with
+ * If-None-Match instead of downloading them again.
+ */
+
+#pragma once
+
+#include <zephyr/kernel.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Compressed static asset
+ */
+struct web_asset {
+	const char *path;          /**< Request path, e.g. "/style.css" */
+	const char *content_type;  /**< MIME type of the uncompressed content */
+	const uint8_t *data;       /**< gzip-compressed content */
+	size_t len;                /**< Length of data */
+	const char *etag;          /**< Quoted strong ETag */
+};
+
+/** Generated asset table */
+extern const struct web_asset web_assets[];
+
+/** Number of entries in web_assets */
+extern const size_t web_assets_count;
+
+/**
+ * @brief Look up an asset by request path
+ *
+ * @param path Request path (not necessarily NUL-terminated)
+ * @param len Length of path
+ * @return Matching asset, or NULL if none
+ */
+const struct web_asset *web_asset_find(const char *path, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
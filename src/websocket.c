@@ -0,0 +1,188 @@
+/**
+ * @file websocket.c
+ * @brief RFC 6455 WebSocket handshake and framing implementation
+ */
+
+#include "websocket.h"
+#include <zephyr/sys/base64.h>
+#include <zephyr/sys/byteorder.h>
+#include <string.h>
+
+/* Appended to the client key before hashing (RFC 6455 section 1.3) */
+static const char ws_guid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+#define SHA1_DIGEST_LEN 20
+
+static inline uint32_t sha1_rol(uint32_t x, int n)
+{
+	return (x << n) | (x >> (32 - n));
+}
+
+/**
+ * @brief Hash one 64-byte block into the SHA-1 state
+ */
+static void sha1_block(uint32_t h[5], const uint8_t *block)
+{
+	uint32_t w[16];
+	uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+
+	for (int i = 0; i < 16; i++) {
+		w[i] = sys_get_be32(block + i * 4);
+	}
+
+	for (int i = 0; i < 80; i++) {
+		uint32_t f, k, t;
+
+		if (i >= 16) {
+			/* Message schedule kept in a 16-word ring */
+			w[i & 15] = sha1_rol(w[(i + 13) & 15] ^ w[(i + 8) & 15] ^
+			                     w[(i + 2) & 15] ^ w[i & 15], 1);
+		}
+
+		if (i < 20) {
+			f = (b & c) | (~b & d);
+			k = 0x5a827999;
+		} else if (i < 40) {
+			f = b ^ c ^ d;
+			k = 0x6ed9eba1;
+		} else if (i < 60) {
+			f = (b & c) | (b & d) | (c & d);
+			k = 0x8f1bbcdc;
+		} else {
+			f = b ^ c ^ d;
+			k = 0xca62c1d6;
+		}
+
+		t = sha1_rol(a, 5) + f + e + k + w[i & 15];
+		e = d;
+		d = c;
+		c = sha1_rol(b, 30);
+		b = a;
+		a = t;
+	}
+
+	h[0] += a;
+	h[1] += b;
+	h[2] += c;
+	h[3] += d;
+	h[4] += e;
+}
+
+/**
+ * @brief SHA-1 of a short message (at most 119 bytes, two blocks)
+ *
+ * Only the handshake needs SHA-1, and its input has a fixed size, so a
+ * general streaming implementation (or a crypto library) is not needed.
+ */
+static void sha1_short(const uint8_t *msg, size_t len, uint8_t digest[SHA1_DIGEST_LEN])
+{
+	uint32_t h[5] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 };
+	uint8_t blocks[128] = {0};
+	size_t nblocks = (len + 9 > 64) ? 2 : 1;
+
+	__ASSERT_NO_MSG(len <= sizeof(blocks) - 9);
+
+	memcpy(blocks, msg, len);
+	blocks[len] = 0x80;
+	sys_put_be32(0, blocks + nblocks * 64 - 8);
+	sys_put_be32(len * 8, blocks + nblocks * 64 - 4);
+
+	for (size_t i = 0; i < nblocks; i++) {
+		sha1_block(h, blocks + i * 64);
+	}
+
+	for (int i = 0; i < 5; i++) {
+		sys_put_be32(h[i], digest + i * 4);
+	}
+}
+
+int ws_accept_key(const char *key, size_t key_len, char out[WS_ACCEPT_KEY_LEN])
+{
+	uint8_t msg[WS_CLIENT_KEY_LEN + sizeof(ws_guid) - 1];
+	uint8_t digest[SHA1_DIGEST_LEN];
+	size_t olen;
+
+	if (key_len != WS_CLIENT_KEY_LEN) {
+		return -EINVAL;
+	}
+
+	memcpy(msg, key, key_len);
+	memcpy(msg + key_len, ws_guid, sizeof(ws_guid) - 1);
+	sha1_short(msg, sizeof(msg), digest);
+
+	return base64_encode((uint8_t *)out, WS_ACCEPT_KEY_LEN, &olen,
+	                     digest, sizeof(digest));
+}
+
+int ws_frame_decode(uint8_t *buf, size_t len, size_t max, struct ws_frame *frame)
+{
+	size_t hdr_len = 2;
+	uint64_t payload_len;
+	const uint8_t *mask;
+
+	if (len < 2) {
+		return 0;
+	}
+
+	/* No extensions are negotiated, so RSV bits must be clear */
+	if ((buf[0] & 0x70) || !(buf[1] & 0x80)) {
+		return -EBADMSG;
+	}
+
+	frame->fin = (buf[0] & 0x80) != 0;
+	frame->opcode = buf[0] & 0x0f;
+	payload_len = buf[1] & 0x7f;
+
+	if (payload_len == 126) {
+		hdr_len += 2;
+		if (len < hdr_len) {
+			return 0;
+		}
+		payload_len = sys_get_be16(buf + 2);
+	} else if (payload_len == 127) {
+		hdr_len += 8;
+		if (len < hdr_len) {
+			return 0;
+		}
+		payload_len = sys_get_be64(buf + 2);
+	}
+
+	/* Control frames are short and never fragmented */
+	if ((frame->opcode & 0x8) && (payload_len > 125 || !frame->fin)) {
+		return -EBADMSG;
+	}
+
+	hdr_len += 4;
+	if (payload_len > max || hdr_len + payload_len > max) {
+		return -EMSGSIZE;
+	}
+
+	if (len < hdr_len + payload_len) {
+		return 0;
+	}
+
+	mask = buf + hdr_len - 4;
+	frame->payload = buf + hdr_len;
+	frame->payload_len = payload_len;
+	frame->frame_len = hdr_len + payload_len;
+
+	for (size_t i = 0; i < payload_len; i++) {
+		frame->payload[i] ^= mask[i & 3];
+	}
+
+	return 1;
+}
+
+size_t ws_frame_header(uint8_t *out, enum ws_opcode opcode, size_t payload_len)
+{
+	out[0] = 0x80 | opcode;
+
+	if (payload_len < 126) {
+		out[1] = payload_len;
+		return 2;
+	}
+
+	out[1] = 126;
+	sys_put_be16(payload_len, out + 2);
+	return 4;
+}
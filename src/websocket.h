@@ -0,0 +1,102 @@
+/**
+ * @file websocket.h
+ * @brief RFC 6455 WebSocket handshake and framing helpers
+ *
+ * This module holds the protocol pieces of the WebSocket endpoint that do
+ * not depend on sockets: computing the handshake accept key, decoding
+ * client frames in place and encoding server frame headers. Connection
+ * handling lives in the HTTP server.
+ */
+
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Length of a Sec-WebSocket-Key value (16 bytes, base64-encoded) */
+#define WS_CLIENT_KEY_LEN 24
+
+/** Length of a Sec-WebSocket-Accept value including the NUL */
+#define WS_ACCEPT_KEY_LEN 29
+
+/** Largest server frame header (no mask, 16-bit length) */
+#define WS_FRAME_HEADER_MAX 4
+
+/**
+ * @brief Frame opcodes
+ */
+enum ws_opcode {
+	WS_OP_CONTINUATION = 0x0,
+	WS_OP_TEXT = 0x1,
+	WS_OP_BINARY = 0x2,
+	WS_OP_CLOSE = 0x8,
+	WS_OP_PING = 0x9,
+	WS_OP_PONG = 0xA
+};
+
+/**
+ * @brief Close status codes used by the server
+ */
+enum ws_close_code {
+	WS_CLOSE_NORMAL = 1000,
+	WS_CLOSE_GOING_AWAY = 1001,
+	WS_CLOSE_PROTOCOL_ERROR = 1002,
+	WS_CLOSE_UNSUPPORTED = 1003,
+	WS_CLOSE_TOO_BIG = 1009
+};
+
+/**
+ * @brief Decoded client frame
+ *
+ * The payload points into the caller's buffer and has been unmasked.
+ */
+struct ws_frame {
+	enum ws_opcode opcode;
+	bool fin;               /**< Final fragment of a message */
+	uint8_t *payload;
+	size_t payload_len;
+	size_t frame_len;       /**< Header plus payload bytes consumed */
+};
+
+/**
+ * @brief Compute the Sec-WebSocket-Accept value for a client key
+ *
+ * @param key Sec-WebSocket-Key header value (not NUL-terminated)
+ * @param key_len Length of key
+ * @param out Output buffer of WS_ACCEPT_KEY_LEN bytes
+ * @return 0 on success, -EINVAL if the key is malformed
+ */
+int ws_accept_key(const char *key, size_t key_len, char out[WS_ACCEPT_KEY_LEN]);
+
+/**
+ * @brief Decode a client frame at the start of a buffer
+ *
+ * Client frames must be masked; the payload is unmasked in place.
+ *
+ * @param buf Received bytes
+ * @param len Number of bytes in buf
+ * @param max Largest frame the caller can buffer
+ * @param frame Output frame description
+ * @return 1 if a frame was decoded, 0 if more data is needed,
+ *         -EBADMSG for a protocol violation, -EMSGSIZE if the frame
+ *         can never fit in a buffer of @p max bytes
+ */
+int ws_frame_decode(uint8_t *buf, size_t len, size_t max, struct ws_frame *frame);
+
+/**
+ * @brief Encode an unmasked, final server frame header
+ *
+ * @param out Output buffer of at least WS_FRAME_HEADER_MAX bytes
+ * @param opcode Frame opcode
+ * @param payload_len Payload length (at most 65535)
+ * @return Header length in bytes
+ */
+size_t ws_frame_header(uint8_t *out, enum ws_opcode opcode, size_t payload_len);
+
+#ifdef __cplusplus
+}
+#endif
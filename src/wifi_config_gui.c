@@ -10,6 +10,11 @@
 
 LOG_MODULE_REGISTER(wifi_gui, LOG_LEVEL_INF);
 
+/* Cached results younger than this are listed without a new scan */
+#define WIFI_GUI_SCAN_MAX_AGE_MS 60000
+
+static void wifi_gui_scan_work(struct k_work *work);
+
 int wifi_gui_init(struct wifi_gui *gui,
                    struct wifi_scanner *scanner,
                    const struct wifi_gui_display_ops *display_ops)
@@ -22,27 +27,111 @@ int wifi_gui_init(struct wifi_gui *gui,
 	gui->state = WIFI_GUI_IDLE;
 	gui->scanner = scanner;
 	gui->display_ops = display_ops;
+	k_mutex_init(&gui->lock);
+	k_work_init(&gui->scan_work, wifi_gui_scan_work);
 
 	LOG_INF("WiFi GUI initialized");
 	return 0;
 }
 
+/**
+ * @brief Update the display with scan progress; runs on the system work queue
+ */
+static void wifi_gui_scan_work(struct k_work *work)
+{
+	struct wifi_gui *gui = CONTAINER_OF(work, struct wifi_gui, scan_work);
+
+	k_mutex_lock(&gui->lock, K_FOREVER);
+
+	if (!atomic_cas(&gui->scan_done, 1, 0)) {
+		/* Results only; the list itself is published when the scan completes */
+		if (gui->state == WIFI_GUI_SCANNING) {
+			wifi_gui_refresh(gui);
+		}
+	} else if (gui->state == WIFI_GUI_NETWORK_LIST) {
+		/* A newer result set was published */
+		wifi_gui_refresh(gui);
+	} else if (gui->state == WIFI_GUI_SCANNING) {
+		if (gui->scan_status) {
+			LOG_ERR("WiFi scan failed: %d", gui->scan_status);
+			gui->state = WIFI_GUI_FAILED;
+			if (gui->display_ops->show_text) {
+				gui->display_ops->show_text(1, "Scan failed!");
+			}
+		} else {
+			gui->state = WIFI_GUI_NETWORK_LIST;
+			wifi_gui_refresh(gui);
+		}
+	}
+
+	k_mutex_unlock(&gui->lock);
+}
+
+/**
+ * @brief Record scan progress
+ *
+ * Runs in the scanner's context, which must not block, so the display is
+ * updated from scan_work instead.
+ */
+static void wifi_gui_scan_event(enum wifi_scanner_event event,
+                                const struct wifi_scan_result *result,
+                                int status, void *user_data)
+{
+	struct wifi_gui *gui = user_data;
+
+	ARG_UNUSED(result);
+
+	switch (event) {
+	case WIFI_SCANNER_EVT_RESULT:
+		atomic_inc(&gui->scan_found);
+		k_work_submit(&gui->scan_work);
+		break;
+	case WIFI_SCANNER_EVT_DONE:
+		gui->scan_status = status;
+		atomic_set(&gui->scan_done, 1);
+		k_work_submit(&gui->scan_work);
+		break;
+	default:
+		break;
+	}
+}
+
 int wifi_gui_start(struct wifi_gui *gui,
                     wifi_gui_creds_cb_t creds_cb,
                     void *user_data)
 {
+	const struct wifi_scan_snapshot *snap;
+	bool cached;
 	int ret;
 
 	if (!gui) {
 		return -EINVAL;
 	}
 
+	k_mutex_lock(&gui->lock, K_FOREVER);
+
 	gui->creds_cb = creds_cb;
 	gui->cb_user_data = user_data;
 	gui->selected_network = 0;
+	atomic_set(&gui->scan_found, 0);
+	atomic_set(&gui->scan_done, 0);
 	gui->password_cursor = 0;
 	gui->entered_password[0] = '\0';
 
+	/* Recent results, from a background scan for instance, are shown at once */
+	snap = wifi_scanner_snapshot_get(gui->scanner);
+	cached = snap->count > 0 &&
+	         wifi_scanner_snapshot_age_ms(snap) <= WIFI_GUI_SCAN_MAX_AGE_MS;
+	wifi_scanner_snapshot_put(snap);
+
+	if (cached) {
+		LOG_INF("Listing cached scan results");
+		gui->state = WIFI_GUI_NETWORK_LIST;
+		wifi_gui_refresh(gui);
+		k_mutex_unlock(&gui->lock);
+		return 0;
+	}
+
 	/* Clear display */
 	if (gui->display_ops->clear) {
 		gui->display_ops->clear();
@@ -61,22 +150,18 @@ int wifi_gui_start(struct wifi_gui *gui,
 	gui->state = WIFI_GUI_SCANNING;
 	LOG_INF("Starting WiFi scan...");
 
-	/* Perform scan */
-	ret = wifi_scanner_scan(gui->scanner, 10000);
+	/* Networks are counted as they are found and listed at the end */
+	ret = wifi_scanner_scan_async(gui->scanner, 10000, wifi_gui_scan_event, gui);
 	if (ret) {
 		LOG_ERR("WiFi scan failed: %d", ret);
 		gui->state = WIFI_GUI_FAILED;
 		if (gui->display_ops->show_text) {
 			gui->display_ops->show_text(1, "Scan failed!");
 		}
-		return ret;
 	}
 
-	/* Show network list */
-	gui->state = WIFI_GUI_NETWORK_LIST;
-	wifi_gui_refresh(gui);
-
-	return 0;
+	k_mutex_unlock(&gui->lock);
+	return ret;
 }
 
 int wifi_gui_stop(struct wifi_gui *gui)
@@ -85,6 +170,8 @@ int wifi_gui_stop(struct wifi_gui *gui)
 		return -EINVAL;
 	}
 
+	k_mutex_lock(&gui->lock, K_FOREVER);
+
 	gui->state = WIFI_GUI_IDLE;
 
 	if (gui->display_ops->clear) {
@@ -95,6 +182,8 @@ int wifi_gui_stop(struct wifi_gui *gui)
 		gui->display_ops->update();
 	}
 
+	k_mutex_unlock(&gui->lock);
+
 	LOG_INF("WiFi GUI stopped");
 	return 0;
 }
@@ -103,16 +192,18 @@ int wifi_gui_handle_input(struct wifi_gui *gui,
                            enum wifi_gui_input input,
                            char data)
 {
-	size_t count;
-	const struct wifi_scan_result *results;
+	const struct wifi_scan_snapshot *snap;
+	enum wifi_security_type security;
 
 	if (!gui) {
 		return -EINVAL;
 	}
 
+	k_mutex_lock(&gui->lock, K_FOREVER);
+
 	switch (gui->state) {
 	case WIFI_GUI_NETWORK_LIST:
-		results = wifi_scanner_get_results(gui->scanner, &count);
+		snap = wifi_scanner_snapshot_get(gui->scanner);
 
 		if (input == WIFI_GUI_INPUT_UP) {
 			if (gui->selected_network > 0) {
@@ -120,19 +211,24 @@ int wifi_gui_handle_input(struct wifi_gui *gui,
 				wifi_gui_refresh(gui);
 			}
 		} else if (input == WIFI_GUI_INPUT_DOWN) {
-			if (gui->selected_network < count - 1) {
+			if (gui->selected_network + 1 < snap->count) {
 				gui->selected_network++;
 				wifi_gui_refresh(gui);
 			}
 		} else if (input == WIFI_GUI_INPUT_SELECT) {
 			/* Network selected, check if password needed */
-			if (results && gui->selected_network < count) {
+			if (gui->selected_network < snap->count) {
 				strncpy(gui->selected_ssid,
-				        results[gui->selected_network].ssid,
+				        wifi_scanner_entry_ssid(snap, gui->selected_network),
 				        sizeof(gui->selected_ssid) - 1);
 				gui->selected_ssid[sizeof(gui->selected_ssid) - 1] = '\0';
+				security = snap->entries[gui->selected_network].security;
 
-				if (results[gui->selected_network].security == WIFI_SECURITY_TYPE_NONE) {
+				/* Not held across the credentials callback */
+				wifi_scanner_snapshot_put(snap);
+				snap = NULL;
+
+				if (security == WIFI_SECURITY_TYPE_NONE) {
 					/* Open network, connect immediately */
 					gui->entered_password[0] = '\0';
 					if (gui->creds_cb) {
@@ -150,6 +246,8 @@ int wifi_gui_handle_input(struct wifi_gui *gui,
 				wifi_gui_refresh(gui);
 			}
 		}
+
+		wifi_scanner_snapshot_put(snap);
 		break;
 
 	case WIFI_GUI_ENTER_PASSWORD:
@@ -188,6 +286,8 @@ int wifi_gui_handle_input(struct wifi_gui *gui,
 		break;
 	}
 
+	k_mutex_unlock(&gui->lock);
+
 	return 0;
 }
 
@@ -202,13 +302,15 @@ enum wifi_gui_state wifi_gui_get_state(struct wifi_gui *gui)
 
 void wifi_gui_refresh(struct wifi_gui *gui)
 {
-	size_t count;
-	const struct wifi_scan_result *results;
+	const struct wifi_scan_snapshot *snap;
 
 	if (!gui || !gui->display_ops) {
 		return;
 	}
 
+	/* Recursive, so the GUI's own calls under the lock are fine */
+	k_mutex_lock(&gui->lock, K_FOREVER);
+
 	if (gui->display_ops->clear) {
 		gui->display_ops->clear();
 	}
@@ -217,18 +319,26 @@ void wifi_gui_refresh(struct wifi_gui *gui)
 	case WIFI_GUI_SCANNING:
 		if (gui->display_ops->show_text) {
 			gui->display_ops->show_text(0, "WiFi Setup");
-			gui->display_ops->show_text(1, "Scanning...");
+			if (atomic_get(&gui->scan_found) > 0) {
+				char line[32];
+				snprintf(line, sizeof(line), "Scanning... %ld found",
+				         (long)atomic_get(&gui->scan_found));
+				gui->display_ops->show_text(1, line);
+			} else {
+				gui->display_ops->show_text(1, "Scanning...");
+			}
 		}
 		break;
 
 	case WIFI_GUI_NETWORK_LIST:
-		results = wifi_scanner_get_results(gui->scanner, &count);
-		if (gui->display_ops->show_networks && results && count > 0) {
-			gui->display_ops->show_networks(results, count, gui->selected_network);
+		snap = wifi_scanner_snapshot_get(gui->scanner);
+		if (gui->display_ops->show_networks && snap->count > 0) {
+			gui->display_ops->show_networks(snap, gui->selected_network);
 		} else if (gui->display_ops->show_text) {
 			gui->display_ops->show_text(0, "No networks found");
 			gui->display_ops->show_text(1, "Press BACK to rescan");
 		}
+		wifi_scanner_snapshot_put(snap);
 		break;
 
 	case WIFI_GUI_ENTER_PASSWORD:
@@ -272,4 +382,6 @@ void wifi_gui_refresh(struct wifi_gui *gui)
 	if (gui->display_ops->update) {
 		gui->display_ops->update();
 	}
+
+	k_mutex_unlock(&gui->lock);
 }
@@ -47,7 +47,9 @@ enum wifi_gui_input {
  * @brief GUI callbacks for display updates
  *
  * These callbacks are called by the GUI module to update the display.
- * The application must implement these functions.
+ * The application must implement these functions. While a scan runs they
+ * are also called from the system work queue, to show progress and the
+ * list once the scan completes; calls never overlap.
  */
 struct wifi_gui_display_ops {
 	/**
@@ -66,12 +68,11 @@ struct wifi_gui_display_ops {
 	/**
 	 * @brief Show network list
 	 *
-	 * @param results Array of scan results
-	 * @param count Number of results
+	 * @param snap Scan results, pinned for the duration of the call; read
+	 *             SSIDs with wifi_scanner_entry_ssid()
 	 * @param selected Index of selected item
 	 */
-	void (*show_networks)(const struct wifi_scan_result *results,
-	                      size_t count, size_t selected);
+	void (*show_networks)(const struct wifi_scan_snapshot *snap, size_t selected);
 
 	/**
 	 * @brief Show password entry screen
@@ -110,6 +111,12 @@ struct wifi_gui {
 	wifi_gui_creds_cb_t creds_cb;
 	void *cb_user_data;
 
+	struct k_mutex lock;    /**< Guards the UI state and display calls */
+	struct k_work scan_work;  /**< Applies scan progress outside the scanner's context */
+	atomic_t scan_found;    /**< Networks reported by the running scan */
+	atomic_t scan_done;     /**< Set when the scan ended, cleared by scan_work */
+	int scan_status;        /**< Status of the ended scan */
+
 	/* UI state */
 	size_t selected_network;
 	char selected_ssid[33];
@@ -132,7 +139,10 @@ int wifi_gui_init(struct wifi_gui *gui,
 /**
  * @brief Start the WiFi configuration GUI
  *
- * Begins the configuration process by scanning for networks
+ * Begins the configuration process by scanning for networks. Returns
+ * once the scan has started; the display counts networks as they are
+ * found and shows the list when the scan completes. Results less than a
+ * minute old are listed straight away instead.
  *
  * @param gui Pointer to GUI context
  * @param creds_cb Callback for credential submission
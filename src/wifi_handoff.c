@@ -0,0 +1,368 @@
+/**
+ * @file wifi_handoff.c
+ * @brief Provisioning to station mode handoff implementation
+ */
+
+#include "wifi_handoff.h"
+#include <zephyr/net/net_if.h>
+#include <zephyr/net/net_event.h>
+#include <zephyr/net/wifi_mgmt.h>
+#include <zephyr/logging/log.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(wifi_handoff, LOG_LEVEL_INF);
+
+/* Work queue thread */
+#define WIFI_HANDOFF_STACK_SIZE 3072
+#define WIFI_HANDOFF_PRIORITY 7
+
+/* Upper bounds per stage; each normally ends on its event much sooner.
+ * A missing AP disable event is not fatal, the driver may not send one.
+ */
+#define WIFI_HANDOFF_AP_TIMEOUT_MS 3000
+#define WIFI_HANDOFF_CONNECT_TIMEOUT_MS 30000
+#define WIFI_HANDOFF_ADDRESS_TIMEOUT_MS 20000
+
+/* Bits in wifi_handoff.events */
+enum {
+	WIFI_HANDOFF_EVT_AP_DISABLED,
+	WIFI_HANDOFF_EVT_CONNECT_RESULT,
+	WIFI_HANDOFF_EVT_IPV4_ADDED,
+	WIFI_HANDOFF_EVT_TIMEOUT
+};
+
+K_THREAD_STACK_DEFINE(wifi_handoff_stack, WIFI_HANDOFF_STACK_SIZE);
+static struct k_work_q wifi_handoff_q;
+static bool wifi_handoff_q_started;
+
+static bool wifi_handoff_active(const struct wifi_handoff *handoff)
+{
+	return handoff->stage != WIFI_HANDOFF_IDLE &&
+	       handoff->stage != WIFI_HANDOFF_DONE &&
+	       handoff->stage != WIFI_HANDOFF_FAILED;
+}
+
+/**
+ * @brief Latch an event and schedule a step
+ */
+static void wifi_handoff_post(struct wifi_handoff *handoff, int event)
+{
+	atomic_set_bit(&handoff->events, event);
+	k_work_submit_to_queue(&wifi_handoff_q, &handoff->step);
+}
+
+/**
+ * @brief Wi-Fi management events (AP disable, connect result)
+ */
+static void wifi_handoff_wifi_event(struct net_mgmt_event_callback *cb,
+                                    uint64_t mgmt_event, struct net_if *iface)
+{
+	struct wifi_handoff *handoff = CONTAINER_OF(cb, struct wifi_handoff, wifi_cb);
+	const struct wifi_status *status = (const struct wifi_status *)cb->info;
+
+	if (!wifi_handoff_active(handoff)) {
+		return;
+	}
+
+	switch (mgmt_event) {
+	case NET_EVENT_WIFI_AP_DISABLE_RESULT:
+		wifi_handoff_post(handoff, WIFI_HANDOFF_EVT_AP_DISABLED);
+		break;
+	case NET_EVENT_WIFI_CONNECT_RESULT:
+		handoff->connect_status = status ? status->status : -EIO;
+		wifi_handoff_post(handoff, WIFI_HANDOFF_EVT_CONNECT_RESULT);
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * @brief IPv4 events (address added)
+ */
+static void wifi_handoff_ipv4_event(struct net_mgmt_event_callback *cb,
+                                    uint64_t mgmt_event, struct net_if *iface)
+{
+	struct wifi_handoff *handoff = CONTAINER_OF(cb, struct wifi_handoff, ipv4_cb);
+
+	if (mgmt_event == NET_EVENT_IPV4_ADDR_ADD && wifi_handoff_active(handoff)) {
+		wifi_handoff_post(handoff, WIFI_HANDOFF_EVT_IPV4_ADDED);
+	}
+}
+
+static void wifi_handoff_timeout(struct k_work *work)
+{
+	struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+	struct wifi_handoff *handoff = CONTAINER_OF(dwork, struct wifi_handoff, timeout);
+
+	wifi_handoff_post(handoff, WIFI_HANDOFF_EVT_TIMEOUT);
+}
+
+/**
+ * @brief Close the current stage's timing and enter the next one
+ *
+ * @param handoff Handoff context
+ * @param stage Next stage
+ * @param timeout_ms Deadline for the next stage, 0 for none
+ */
+static void wifi_handoff_enter(struct wifi_handoff *handoff,
+                               enum wifi_handoff_stage stage, uint32_t timeout_ms)
+{
+	int64_t now = k_uptime_get();
+
+	handoff->stage_ms[handoff->stage] = now - handoff->stage_start;
+	handoff->stage_start = now;
+	handoff->stage = stage;
+
+	/* Timeouts run on our queue, so no stale one can fire after this */
+	atomic_clear_bit(&handoff->events, WIFI_HANDOFF_EVT_TIMEOUT);
+	if (timeout_ms) {
+		k_work_reschedule_for_queue(&wifi_handoff_q, &handoff->timeout,
+		                            K_MSEC(timeout_ms));
+	} else {
+		k_work_cancel_delayable(&handoff->timeout);
+	}
+
+	LOG_INF("Handoff stage: %s (+%u ms)", wifi_handoff_stage_to_string(stage),
+	        (uint32_t)(now - handoff->submitted));
+}
+
+/**
+ * @brief End the handoff and report its timing
+ */
+static void wifi_handoff_finish(struct wifi_handoff *handoff, int status)
+{
+	wifi_handoff_enter(handoff, status ? WIFI_HANDOFF_FAILED : WIFI_HANDOFF_DONE, 0);
+	handoff->status = status;
+	handoff->total_ms = handoff->stage_start - handoff->submitted;
+
+	/* The passphrase is no longer needed here */
+	memset(handoff->psk, 0, sizeof(handoff->psk));
+
+	LOG_INF("Handoff %s in %u ms (save %u, AP off %u, connect %u, address %u)",
+	        status ? "failed" : "complete", handoff->total_ms,
+	        handoff->stage_ms[WIFI_HANDOFF_SAVING],
+	        handoff->stage_ms[WIFI_HANDOFF_STOPPING_AP],
+	        handoff->stage_ms[WIFI_HANDOFF_CONNECTING],
+	        handoff->stage_ms[WIFI_HANDOFF_ADDRESSING]);
+
+	if (handoff->done_cb) {
+		handoff->done_cb(status, handoff->user_data);
+	}
+}
+
+/**
+ * @brief Issue the station connect request
+ */
+static void wifi_handoff_connect(struct wifi_handoff *handoff)
+{
+	struct net_if *iface = net_if_get_default();
+	struct wifi_connect_req_params params = {0};
+	size_t psk_len = strlen(handoff->psk);
+	int ret;
+
+	if (!iface) {
+		wifi_handoff_finish(handoff, -ENODEV);
+		return;
+	}
+
+	params.ssid = (const uint8_t *)handoff->ssid;
+	params.ssid_length = strlen(handoff->ssid);
+	params.psk = (const uint8_t *)handoff->psk;
+	params.psk_length = psk_len;
+	params.channel = WIFI_CHANNEL_ANY;
+	params.security = psk_len ? WIFI_SECURITY_TYPE_PSK : WIFI_SECURITY_TYPE_NONE;
+	params.band = WIFI_FREQ_BAND_2_4_GHZ;
+	params.mfp = WIFI_MFP_OPTIONAL;
+
+	atomic_clear_bit(&handoff->events, WIFI_HANDOFF_EVT_CONNECT_RESULT);
+	atomic_clear_bit(&handoff->events, WIFI_HANDOFF_EVT_IPV4_ADDED);
+	wifi_handoff_enter(handoff, WIFI_HANDOFF_CONNECTING,
+	                   WIFI_HANDOFF_CONNECT_TIMEOUT_MS);
+
+	ret = net_mgmt(NET_REQUEST_WIFI_CONNECT, iface, &params, sizeof(params));
+	if (ret) {
+		LOG_ERR("Connect request failed: %d", ret);
+		wifi_handoff_finish(handoff, ret);
+	}
+}
+
+/**
+ * @brief Advance the state machine on latched events
+ */
+static void wifi_handoff_step(struct k_work *work)
+{
+	struct wifi_handoff *handoff = CONTAINER_OF(work, struct wifi_handoff, step);
+	bool timed_out = atomic_test_and_clear_bit(&handoff->events,
+	                                           WIFI_HANDOFF_EVT_TIMEOUT);
+	int ret;
+
+	switch (handoff->stage) {
+	case WIFI_HANDOFF_SAVING:
+		if (handoff->save_cb) {
+			ret = handoff->save_cb(handoff->user_data);
+			if (ret) {
+				LOG_WRN("Saving credentials failed: %d", ret);
+			}
+		}
+
+		/* Not on the server thread, so this waits for it to exit */
+		if (handoff->http) {
+			(void)http_server_stop(handoff->http);
+		}
+
+		atomic_clear_bit(&handoff->events, WIFI_HANDOFF_EVT_AP_DISABLED);
+		wifi_handoff_enter(handoff, WIFI_HANDOFF_STOPPING_AP,
+		                   WIFI_HANDOFF_AP_TIMEOUT_MS);
+
+		/* No AP to wait for when it was never started */
+		if (!handoff->ap || wifi_ap_provisioning_stop(handoff->ap) != 0) {
+			wifi_handoff_connect(handoff);
+		}
+		break;
+
+	case WIFI_HANDOFF_STOPPING_AP:
+		if (atomic_test_and_clear_bit(&handoff->events,
+		                              WIFI_HANDOFF_EVT_AP_DISABLED)) {
+			wifi_handoff_connect(handoff);
+		} else if (timed_out) {
+			LOG_WRN("No AP disable event, connecting anyway");
+			wifi_handoff_connect(handoff);
+		}
+		break;
+
+	case WIFI_HANDOFF_CONNECTING:
+		if (atomic_test_and_clear_bit(&handoff->events,
+		                              WIFI_HANDOFF_EVT_CONNECT_RESULT)) {
+			if (handoff->connect_status != 0) {
+				LOG_ERR("Connection failed: %d", handoff->connect_status);
+				wifi_handoff_finish(handoff, -ECONNREFUSED);
+				break;
+			}
+			wifi_handoff_enter(handoff, WIFI_HANDOFF_ADDRESSING,
+			                   WIFI_HANDOFF_ADDRESS_TIMEOUT_MS);
+			/* The address may have been reported in the same batch */
+			if (atomic_test_and_clear_bit(&handoff->events,
+			                              WIFI_HANDOFF_EVT_IPV4_ADDED)) {
+				wifi_handoff_finish(handoff, 0);
+			}
+		} else if (timed_out) {
+			wifi_handoff_finish(handoff, -ETIMEDOUT);
+		}
+		break;
+
+	case WIFI_HANDOFF_ADDRESSING:
+		if (atomic_test_and_clear_bit(&handoff->events,
+		                              WIFI_HANDOFF_EVT_IPV4_ADDED)) {
+			wifi_handoff_finish(handoff, 0);
+		} else if (timed_out) {
+			wifi_handoff_finish(handoff, -ETIMEDOUT);
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+int wifi_handoff_init(struct wifi_handoff *handoff, struct http_server *http,
+                      struct wifi_ap_provisioning *ap)
+{
+	if (!handoff) {
+		return -EINVAL;
+	}
+
+	if (!wifi_handoff_q_started) {
+		const struct k_work_queue_config cfg = { .name = "wifi_handoff" };
+
+		k_work_queue_init(&wifi_handoff_q);
+		k_work_queue_start(&wifi_handoff_q, wifi_handoff_stack,
+		                   K_THREAD_STACK_SIZEOF(wifi_handoff_stack),
+		                   WIFI_HANDOFF_PRIORITY, &cfg);
+		wifi_handoff_q_started = true;
+	}
+
+	memset(handoff, 0, sizeof(*handoff));
+	handoff->stage = WIFI_HANDOFF_IDLE;
+	handoff->http = http;
+	handoff->ap = ap;
+	k_work_init(&handoff->step, wifi_handoff_step);
+	k_work_init_delayable(&handoff->timeout, wifi_handoff_timeout);
+
+	net_mgmt_init_event_callback(&handoff->wifi_cb, wifi_handoff_wifi_event,
+	                             NET_EVENT_WIFI_AP_DISABLE_RESULT |
+	                             NET_EVENT_WIFI_CONNECT_RESULT);
+	net_mgmt_add_event_callback(&handoff->wifi_cb);
+
+	net_mgmt_init_event_callback(&handoff->ipv4_cb, wifi_handoff_ipv4_event,
+	                             NET_EVENT_IPV4_ADDR_ADD);
+	net_mgmt_add_event_callback(&handoff->ipv4_cb);
+
+	LOG_INF("WiFi handoff initialized");
+	return 0;
+}
+
+int wifi_handoff_start(struct wifi_handoff *handoff, const char *ssid,
+                       const char *psk, wifi_handoff_save_cb_t save_cb,
+                       wifi_handoff_done_cb_t done_cb, void *user_data)
+{
+	if (!handoff || !ssid || !ssid[0] || strlen(ssid) >= sizeof(handoff->ssid) ||
+	    (psk && strlen(psk) >= sizeof(handoff->psk))) {
+		return -EINVAL;
+	}
+
+	if (wifi_handoff_active(handoff)) {
+		return -EBUSY;
+	}
+
+	strcpy(handoff->ssid, ssid);
+	strcpy(handoff->psk, psk ? psk : "");
+	handoff->save_cb = save_cb;
+	handoff->done_cb = done_cb;
+	handoff->user_data = user_data;
+	handoff->status = 0;
+	handoff->total_ms = 0;
+	memset(handoff->stage_ms, 0, sizeof(handoff->stage_ms));
+
+	/* Drop anything seen before this handoff, e.g. the AP's own address */
+	atomic_clear(&handoff->events);
+
+	handoff->submitted = k_uptime_get();
+	handoff->stage_start = handoff->submitted;
+	handoff->stage = WIFI_HANDOFF_SAVING;
+	k_work_submit_to_queue(&wifi_handoff_q, &handoff->step);
+
+	LOG_INF("Handoff to '%s' started", handoff->ssid);
+	return 0;
+}
+
+enum wifi_handoff_stage wifi_handoff_get_stage(const struct wifi_handoff *handoff)
+{
+	if (!handoff) {
+		return WIFI_HANDOFF_IDLE;
+	}
+
+	return handoff->stage;
+}
+
+const char *wifi_handoff_stage_to_string(enum wifi_handoff_stage stage)
+{
+	switch (stage) {
+	case WIFI_HANDOFF_IDLE:
+		return "idle";
+	case WIFI_HANDOFF_SAVING:
+		return "saving";
+	case WIFI_HANDOFF_STOPPING_AP:
+		return "stopping AP";
+	case WIFI_HANDOFF_CONNECTING:
+		return "connecting";
+	case WIFI_HANDOFF_ADDRESSING:
+		return "addressing";
+	case WIFI_HANDOFF_DONE:
+		return "done";
+	case WIFI_HANDOFF_FAILED:
+		return "failed";
+	default:
+		return "unknown";
+	}
+}
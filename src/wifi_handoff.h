@@ -0,0 +1,138 @@
+/**
+ * @file wifi_handoff.h
+ * @brief Provisioning to station mode handoff
+ *
+ * After credentials are submitted, the device must persist them, shut
+ * down the provisioning HTTP server and access point, join the new
+ * network and obtain an address. This module runs those steps as a
+ * state machine on its own work queue, so neither the HTTP server thread
+ * nor the GUI is blocked while they happen.
+ *
+ * Each stage ends on the network management event that completes it (AP
+ * disabled, connect result, IPv4 address added). Timers only bound how
+ * long a stage may take. The time spent in each stage is recorded, so
+ * the whole handoff, from credential submission to IP address, can be
+ * measured.
+ */
+
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <zephyr/net/net_mgmt.h>
+#include "http_server.h"
+#include "wifi_ap_provisioning.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Handoff stage
+ */
+enum wifi_handoff_stage {
+	WIFI_HANDOFF_IDLE,          /**< No handoff started */
+	WIFI_HANDOFF_SAVING,        /**< Persisting credentials, stopping the server */
+	WIFI_HANDOFF_STOPPING_AP,   /**< Waiting for the AP to be disabled */
+	WIFI_HANDOFF_CONNECTING,    /**< Waiting for the connect result */
+	WIFI_HANDOFF_ADDRESSING,    /**< Waiting for an IPv4 address */
+	WIFI_HANDOFF_DONE,          /**< Connected with an address */
+	WIFI_HANDOFF_FAILED         /**< Gave up, see status */
+};
+
+/**
+ * @brief Credential persistence callback
+ *
+ * Runs on the handoff work queue.
+ *
+ * @param user_data User data pointer
+ * @return 0 on success, negative errno on failure (the handoff continues)
+ */
+typedef int (*wifi_handoff_save_cb_t)(void *user_data);
+
+/**
+ * @brief Handoff completion callback
+ *
+ * Runs on the handoff work queue.
+ *
+ * @param status 0 once an address is assigned, negative errno on failure
+ * @param user_data User data pointer
+ */
+typedef void (*wifi_handoff_done_cb_t)(int status, void *user_data);
+
+/**
+ * @brief Handoff context
+ */
+struct wifi_handoff {
+	enum wifi_handoff_stage stage;
+	int status;             /**< Result once DONE or FAILED */
+	struct http_server *http;
+	struct wifi_ap_provisioning *ap;
+	wifi_handoff_save_cb_t save_cb;
+	wifi_handoff_done_cb_t done_cb;
+	void *user_data;
+	char ssid[33];
+	char psk[65];
+
+	struct k_work step;             /**< Advances the state machine */
+	struct k_work_delayable timeout;
+	atomic_t events;                /**< Events latched for the next step */
+	int connect_status;
+	struct net_mgmt_event_callback wifi_cb;
+	struct net_mgmt_event_callback ipv4_cb;
+
+	/* Instrumentation */
+	int64_t submitted;              /**< Uptime of the start request (ms) */
+	int64_t stage_start;            /**< Uptime the current stage began (ms) */
+	uint32_t stage_ms[WIFI_HANDOFF_DONE];  /**< Time spent in each stage */
+	uint32_t total_ms;              /**< Submission to DONE or FAILED */
+};
+
+/**
+ * @brief Initialize the handoff and start its work queue
+ *
+ * @param handoff Pointer to handoff context
+ * @param http HTTP server to stop, or NULL
+ * @param ap Access point to disable, or NULL
+ * @return 0 on success, negative errno on failure
+ */
+int wifi_handoff_init(struct wifi_handoff *handoff, struct http_server *http,
+                      struct wifi_ap_provisioning *ap);
+
+/**
+ * @brief Start a handoff to a new network
+ *
+ * Returns immediately; safe to call from the HTTP server thread,
+ * including from its credentials callback.
+ *
+ * @param handoff Pointer to handoff context
+ * @param ssid Network to join
+ * @param psk Passphrase, empty for an open network
+ * @param save_cb Persists the credentials, or NULL
+ * @param done_cb Reports the result, or NULL
+ * @param user_data User data passed to the callbacks
+ * @return 0 on success, -EBUSY if a handoff is in progress, -EINVAL for
+ *         bad arguments
+ */
+int wifi_handoff_start(struct wifi_handoff *handoff, const char *ssid,
+                       const char *psk, wifi_handoff_save_cb_t save_cb,
+                       wifi_handoff_done_cb_t done_cb, void *user_data);
+
+/**
+ * @brief Get the current stage
+ *
+ * @param handoff Pointer to handoff context
+ * @return Current stage
+ */
+enum wifi_handoff_stage wifi_handoff_get_stage(const struct wifi_handoff *handoff);
+
+/**
+ * @brief Get a printable stage name
+ *
+ * @param stage Stage
+ * @return Stage name
+ */
+const char *wifi_handoff_stage_to_string(enum wifi_handoff_stage stage);
+
+#ifdef __cplusplus
+}
+#endif
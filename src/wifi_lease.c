@@ -0,0 +1,322 @@
+/**
+ * @file wifi_lease.c
+ * @brief IPv4 address setup after association implementation
+ */
+
+#include "wifi_lease.h"
+#include <zephyr/net/net_ip.h>
+#include <zephyr/net/dhcpv4.h>
+#include <zephyr/net/net_mgmt.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/logging/log.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(wifi_lease, LOG_LEVEL_INF);
+
+/*
+ * Lease time that must be left to reuse a lease bound before the last
+ * reset. There is no clock across resets, so this has to cover the time
+ * the device was off.
+ */
+#define WIFI_LEASE_MIN_REUSE_S 3600
+
+/* Lease time that must be left to reuse a lease bound since boot */
+#define WIFI_LEASE_MIN_LEFT_S 60
+
+static struct wifi_lease cached;
+static int64_t cached_bound_at;         /* Uptime the lease was bound (ms), 0 if before boot */
+static struct in_addr provisional;      /* Cached address in use, unconfirmed */
+static struct net_if *provisional_iface;
+static bool provisional_conflict;       /* Another host holds the cached address */
+static struct net_if *bound_iface;
+static K_MUTEX_DEFINE(lease_lock);
+
+static void wifi_lease_bound_work(struct k_work *work);
+static K_WORK_DEFINE(bound_work, wifi_lease_bound_work);
+
+#ifdef CONFIG_SLIDER_WIFI_LEASE_REUSE
+static void wifi_lease_withdraw_work(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(withdraw_work, wifi_lease_withdraw_work);
+#endif
+
+#ifdef CONFIG_SLIDER_WIFI_STATIC_IP
+/**
+ * @brief Assign the configured static address
+ */
+static int wifi_lease_static(struct net_if *iface)
+{
+	struct in_addr addr, netmask, gw;
+
+	if (net_addr_pton(AF_INET, CONFIG_SLIDER_WIFI_STATIC_ADDR, &addr) ||
+	    net_addr_pton(AF_INET, CONFIG_SLIDER_WIFI_STATIC_NETMASK, &netmask) ||
+	    net_addr_pton(AF_INET, CONFIG_SLIDER_WIFI_STATIC_GATEWAY, &gw)) {
+		LOG_ERR("Invalid static IPv4 configuration");
+		return -EINVAL;
+	}
+
+	net_dhcpv4_stop(iface);
+
+	if (!net_if_ipv4_addr_add(iface, &addr, NET_ADDR_MANUAL, 0)) {
+		LOG_ERR("Failed to add static address");
+		return -ENOMEM;
+	}
+
+	net_if_ipv4_set_netmask_by_addr(iface, &addr, &netmask);
+	net_if_ipv4_set_gw(iface, &gw);
+
+	LOG_INF("Using static address %s", CONFIG_SLIDER_WIFI_STATIC_ADDR);
+	return 0;
+}
+#endif /* CONFIG_SLIDER_WIFI_STATIC_IP */
+
+#ifdef CONFIG_SLIDER_WIFI_LEASE_REUSE
+/**
+ * @brief Check that the cached lease has time enough left; lock held
+ *
+ * A lease bound since boot has a known age. One from before the last
+ * reset is at least as old as the uptime, plus however long the device
+ * was off.
+ */
+static bool wifi_lease_time_left(void)
+{
+	int64_t now = k_uptime_get();
+	int64_t age_s;
+	uint32_t min_left_s;
+
+	if (cached_bound_at != 0) {
+		age_s = (now - cached_bound_at) / MSEC_PER_SEC;
+		min_left_s = WIFI_LEASE_MIN_LEFT_S;
+	} else {
+		age_s = now / MSEC_PER_SEC;
+		min_left_s = WIFI_LEASE_MIN_REUSE_S;
+	}
+
+	return (int64_t)cached.lease_s - age_s >= min_left_s;
+}
+
+/**
+ * @brief Withdraw the cached address DHCP has not confirmed
+ *
+ * Runs on the system work queue when DHCP takes too long or stops, or
+ * when ACD finds the address in use; the lease is forgotten then.
+ */
+static void wifi_lease_withdraw_work(struct k_work *work)
+{
+	char buf[NET_IPV4_ADDR_LEN];
+	int rc = 0;
+
+	ARG_UNUSED(work);
+
+	k_mutex_lock(&lease_lock, K_FOREVER);
+
+	if (provisional.s_addr != 0) {
+		LOG_WRN("Withdrawing cached address %s: %s",
+		        net_addr_ntop(AF_INET, &provisional, buf, sizeof(buf)),
+		        provisional_conflict ? "in use by another host" :
+		                               "DHCP did not confirm it");
+		/* Already gone if ACD removed it */
+		(void)net_if_ipv4_addr_rm(provisional_iface, &provisional);
+		provisional.s_addr = 0;
+
+		if (provisional_conflict) {
+			memset(&cached, 0, sizeof(cached));
+			cached_bound_at = 0;
+			rc = settings_delete("lease/last");
+		}
+	}
+	provisional_conflict = false;
+
+	k_mutex_unlock(&lease_lock);
+
+	if (rc && rc != -ENOENT) {
+		LOG_WRN("Failed to delete lease: %d", rc);
+	}
+}
+#endif /* CONFIG_SLIDER_WIFI_LEASE_REUSE */
+
+int wifi_lease_apply(struct net_if *iface, const char *ssid)
+{
+	if (!iface || !ssid) {
+		return -EINVAL;
+	}
+
+#ifdef CONFIG_SLIDER_WIFI_STATIC_IP
+	return wifi_lease_static(iface);
+#else
+	int rc = -ENOENT;
+
+#ifdef CONFIG_SLIDER_WIFI_LEASE_REUSE
+	char buf[NET_IPV4_ADDR_LEN];
+
+	k_mutex_lock(&lease_lock, K_FOREVER);
+
+	if (cached.addr.s_addr != 0 && provisional.s_addr == 0 &&
+	    strcmp(cached.ssid, ssid) == 0 && wifi_lease_time_left()) {
+		/* Tentative until ACD has found no other host using it */
+		if (net_if_ipv4_addr_add(iface, &cached.addr, NET_ADDR_MANUAL, 0)) {
+			net_if_ipv4_set_netmask_by_addr(iface, &cached.addr, &cached.netmask);
+			net_if_ipv4_set_gw(iface, &cached.gw);
+			provisional = cached.addr;
+			provisional_iface = iface;
+			provisional_conflict = false;
+			k_work_reschedule(&withdraw_work,
+			                  K_SECONDS(CONFIG_SLIDER_WIFI_LEASE_CONFIRM_S));
+			rc = 0;
+
+			LOG_INF("Reusing cached address %s until DHCP confirms it",
+			        net_addr_ntop(AF_INET, &cached.addr, buf, sizeof(buf)));
+		}
+	}
+
+	k_mutex_unlock(&lease_lock);
+#endif /* CONFIG_SLIDER_WIFI_LEASE_REUSE */
+
+	/* Confirms the cached address, or replaces it */
+	net_dhcpv4_start(iface);
+
+	return rc;
+#endif /* CONFIG_SLIDER_WIFI_STATIC_IP */
+}
+
+/**
+ * @brief Record a bound lease; runs on the system work queue
+ */
+static void wifi_lease_bound_work(struct k_work *work)
+{
+	struct net_if *iface = bound_iface;
+	struct net_if_ipv4 *ipv4 = iface ? iface->config.ip.ipv4 : NULL;
+	struct wifi_iface_status status = {0};
+	struct wifi_lease lease = {0};
+	int rc;
+
+	ARG_UNUSED(work);
+
+	if (!ipv4) {
+		return;
+	}
+
+	lease.addr = iface->config.dhcpv4.requested_ip;
+	lease.gw = ipv4->gw;
+	lease.lease_s = iface->config.dhcpv4.lease_time;
+
+	for (size_t i = 0; i < ARRAY_SIZE(ipv4->unicast); i++) {
+		if (ipv4->unicast[i].ipv4.address.in_addr.s_addr == lease.addr.s_addr) {
+			lease.netmask = ipv4->unicast[i].netmask;
+			break;
+		}
+	}
+
+	if (net_mgmt(NET_REQUEST_WIFI_IFACE_STATUS, iface, &status, sizeof(status)) == 0) {
+		strncpy(lease.ssid, status.ssid, WIFI_SSID_MAX_LEN);
+	}
+
+	k_mutex_lock(&lease_lock, K_FOREVER);
+
+#ifdef CONFIG_SLIDER_WIFI_LEASE_REUSE
+	k_work_cancel_delayable(&withdraw_work);
+#endif
+	if (provisional.s_addr != 0 && provisional.s_addr != lease.addr.s_addr) {
+		LOG_WRN("DHCP assigned a different address, dropping the cached one");
+		net_if_ipv4_addr_rm(iface, &provisional);
+	}
+	provisional.s_addr = 0;
+
+	if (lease.ssid[0] != '\0') {
+		if (memcmp(&lease, &cached, sizeof(lease)) != 0) {
+			cached = lease;
+			rc = settings_save_one("lease/last", &cached, sizeof(cached));
+			if (rc) {
+				LOG_WRN("Failed to save lease: %d", rc);
+			}
+		}
+		/* Renewals restart the lease time too */
+		cached_bound_at = k_uptime_get();
+	}
+
+	k_mutex_unlock(&lease_lock);
+}
+
+void wifi_lease_bound(struct net_if *iface)
+{
+	bound_iface = iface;
+	k_work_submit(&bound_work);
+}
+
+void wifi_lease_withdraw(struct net_if *iface, bool conflict)
+{
+#ifdef CONFIG_SLIDER_WIFI_LEASE_REUSE
+	k_mutex_lock(&lease_lock, K_FOREVER);
+
+	if (provisional.s_addr != 0 && iface == provisional_iface) {
+		provisional_conflict |= conflict;
+		k_work_reschedule(&withdraw_work, K_NO_WAIT);
+	}
+
+	k_mutex_unlock(&lease_lock);
+#else
+	ARG_UNUSED(iface);
+	ARG_UNUSED(conflict);
+#endif
+}
+
+void wifi_lease_clear(void)
+{
+	int rc;
+
+	k_mutex_lock(&lease_lock, K_FOREVER);
+	memset(&cached, 0, sizeof(cached));
+	cached_bound_at = 0;
+	k_mutex_unlock(&lease_lock);
+
+	rc = settings_delete("lease/last");
+	if (rc && rc != -ENOENT) {
+		LOG_WRN("Failed to delete lease: %d", rc);
+	}
+}
+
+int wifi_lease_get(struct wifi_lease *lease)
+{
+	int rc = -ENOENT;
+
+	k_mutex_lock(&lease_lock, K_FOREVER);
+	if (cached.addr.s_addr != 0) {
+		*lease = cached;
+		rc = 0;
+	}
+	k_mutex_unlock(&lease_lock);
+
+	return rc;
+}
+
+/*
+ * Settings handler: Set (called when loading "lease/last")
+ */
+static int wifi_lease_handle_set(const char *name, size_t len,
+                                 settings_read_cb read_cb, void *cb_arg)
+{
+	ssize_t rc;
+
+	if (strcmp(name, "last") != 0) {
+		return -ENOENT;
+	}
+
+	if (len != sizeof(cached)) {
+		return 0;
+	}
+
+	k_mutex_lock(&lease_lock, K_FOREVER);
+	rc = read_cb(cb_arg, &cached, sizeof(cached));
+	cached.ssid[WIFI_SSID_MAX_LEN] = '\0';
+	if (rc < 0) {
+		memset(&cached, 0, sizeof(cached));
+	}
+	k_mutex_unlock(&lease_lock);
+
+	return rc < 0 ? rc : 0;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(wifi_lease_handler, "lease",
+                               NULL,                   /* h_get */
+                               wifi_lease_handle_set,  /* h_set */
+                               NULL,                   /* h_commit */
+                               NULL);                  /* h_export */
@@ -0,0 +1,92 @@
+/**
+ * @file wifi_lease.h
+ * @brief IPv4 address setup after association
+ *
+ * By default the address comes from DHCP. The last lease (address,
+ * netmask, gateway, lease time) is saved under "lease/last", and when the
+ * device rejoins the same network with enough of the lease left, it puts
+ * that address to use straight away while the DHCP client confirms it in
+ * the background. An address is therefore usable once the association
+ * and a conflict check (IPv4 ACD) complete, instead of one DHCP exchange
+ * later. The cached address is withdrawn if the server hands out another
+ * one, if DHCP stops or does not confirm it in time, and if another host
+ * turns out to use it; in that last case the lease is also forgotten.
+ *
+ * With CONFIG_SLIDER_WIFI_STATIC_IP, DHCP is not used at all and the
+ * configured address is assigned instead.
+ */
+
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <zephyr/net/net_if.h>
+#include <zephyr/net/wifi_mgmt.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Saved DHCP lease
+ */
+struct wifi_lease {
+	char ssid[WIFI_SSID_MAX_LEN + 1];  /**< Network the lease is from */
+	struct in_addr addr;
+	struct in_addr netmask;
+	struct in_addr gw;
+	uint32_t lease_s;       /**< Lease time granted by the server */
+};
+
+/**
+ * @brief Set up an address after associating
+ *
+ * Assigns the static address, or the cached lease for @p ssid, and
+ * starts the DHCP client when DHCP is in use.
+ *
+ * @param iface Station interface
+ * @param ssid Network just joined
+ * @return 0 if an address was assigned at once, -ENOENT if it has to
+ *         come from DHCP, other negative errno on failure
+ */
+int wifi_lease_apply(struct net_if *iface, const char *ssid);
+
+/**
+ * @brief Handle a completed DHCP exchange
+ *
+ * Call from the NET_EVENT_IPV4_DHCP_BOUND handler. Withdraws a cached
+ * address the server did not grant and saves the new lease; the work is
+ * deferred to the system work queue.
+ *
+ * @param iface Interface the lease was bound on
+ */
+void wifi_lease_bound(struct net_if *iface);
+
+/**
+ * @brief Withdraw a cached address DHCP has not confirmed yet
+ *
+ * Call when the DHCP client stops (NET_EVENT_IPV4_DHCP_STOP), and with
+ * @p conflict when an address fails its conflict check
+ * (NET_EVENT_IPV4_ACD_FAILED). Does nothing once DHCP has bound. The
+ * work is deferred to the system work queue.
+ *
+ * @param iface Interface the event is for
+ * @param conflict Another host uses the address; forget the lease too
+ */
+void wifi_lease_withdraw(struct net_if *iface, bool conflict);
+
+/**
+ * @brief Forget the saved lease
+ */
+void wifi_lease_clear(void);
+
+/**
+ * @brief Copy the saved lease
+ *
+ * @param lease Output lease
+ * @return 0 on success, -ENOENT if no lease is saved
+ */
+int wifi_lease_get(struct wifi_lease *lease);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,326 @@
+/**
+ * @file wifi_profiles.c
+ * @brief Stored WiFi network profiles implementation
+ */
+
+#include "wifi_profiles.h"
+#include <zephyr/settings/settings.h>
+#include <zephyr/logging/log.h>
+#include <stdlib.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(wifi_profiles, LOG_LEVEL_INF);
+
+/* Ranking weights, in points */
+#define WIFI_PROFILES_SEEN_BONUS      1000  /* in the scan; beats any history */
+#define WIFI_PROFILES_RSSI_FLOOR      -100  /* dBm scored as 0 */
+#define WIFI_PROFILES_RSSI_WEIGHT     4     /* per dB above the floor */
+#define WIFI_PROFILES_LAST_USED_BONUS 200   /* the most recent success */
+#define WIFI_PROFILES_KNOWN_BONUS     100   /* any earlier success */
+#define WIFI_PROFILES_FAIL_PENALTY    60    /* per failure since last success */
+#define WIFI_PROFILES_FAIL_MAX        5     /* failures counted at most */
+#define WIFI_PROFILES_SLOW_PENALTY_MS 100   /* 1 point per this much connect time */
+
+static struct wifi_profile profiles[WIFI_PROFILES_MAX];
+static uint32_t success_seq;    /* Highest last_success in the store */
+static K_MUTEX_DEFINE(profiles_lock);
+
+/**
+ * @brief Persist one slot, deleting the record if the slot is unused
+ */
+static void wifi_profiles_save(size_t slot)
+{
+	char key[24];
+	int rc;
+
+	snprintk(key, sizeof(key), "profiles/%u", (unsigned int)slot);
+
+	if (profiles[slot].ssid[0] == '\0') {
+		rc = settings_delete(key);
+	} else {
+		rc = settings_save_one(key, &profiles[slot], sizeof(profiles[slot]));
+	}
+
+	if (rc && rc != -ENOENT) {
+		LOG_WRN("Failed to save profile %u: %d", (unsigned int)slot, rc);
+	}
+}
+
+static int wifi_profiles_find(const char *ssid)
+{
+	for (size_t i = 0; i < WIFI_PROFILES_MAX; i++) {
+		if (profiles[i].ssid[0] != '\0' && strcmp(profiles[i].ssid, ssid) == 0) {
+			return i;
+		}
+	}
+
+	return -ENOENT;
+}
+
+int wifi_profiles_add(const char *ssid, const char *psk)
+{
+	size_t ssid_len = ssid ? strlen(ssid) : 0;
+	int slot;
+
+	if (ssid_len == 0 || ssid_len > WIFI_SSID_MAX_LEN ||
+	    !psk || strlen(psk) > WIFI_PSK_MAX_LEN) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&profiles_lock, K_FOREVER);
+
+	slot = wifi_profiles_find(ssid);
+	if (slot >= 0) {
+		if (strcmp(profiles[slot].psk, psk) != 0) {
+			strcpy(profiles[slot].psk, psk);
+			/* Earlier failures may have been down to the old passphrase */
+			profiles[slot].stats.fail_streak = 0;
+			wifi_profiles_save(slot);
+		}
+		k_mutex_unlock(&profiles_lock);
+		return slot;
+	}
+
+	/* Free slot, else the one that has gone longest without a success */
+	slot = 0;
+	for (size_t i = 0; i < WIFI_PROFILES_MAX; i++) {
+		if (profiles[i].ssid[0] == '\0') {
+			slot = i;
+			break;
+		}
+		if (profiles[i].stats.last_success < profiles[slot].stats.last_success) {
+			slot = i;
+		}
+	}
+
+	if (profiles[slot].ssid[0] != '\0') {
+		LOG_INF("Profile store full, replacing '%s'", profiles[slot].ssid);
+	}
+
+	memset(&profiles[slot], 0, sizeof(profiles[slot]));
+	strcpy(profiles[slot].ssid, ssid);
+	strcpy(profiles[slot].psk, psk);
+	wifi_profiles_save(slot);
+
+	k_mutex_unlock(&profiles_lock);
+
+	LOG_INF("Stored profile '%s' in slot %d", ssid, slot);
+	return slot;
+}
+
+int wifi_profiles_remove(const char *ssid)
+{
+	int slot;
+
+	k_mutex_lock(&profiles_lock, K_FOREVER);
+
+	slot = wifi_profiles_find(ssid);
+	if (slot >= 0) {
+		memset(&profiles[slot], 0, sizeof(profiles[slot]));
+		wifi_profiles_save(slot);
+	}
+
+	k_mutex_unlock(&profiles_lock);
+
+	return slot < 0 ? slot : 0;
+}
+
+void wifi_profiles_clear(void)
+{
+	k_mutex_lock(&profiles_lock, K_FOREVER);
+
+	for (size_t i = 0; i < WIFI_PROFILES_MAX; i++) {
+		if (profiles[i].ssid[0] != '\0') {
+			memset(&profiles[i], 0, sizeof(profiles[i]));
+			wifi_profiles_save(i);
+		}
+	}
+	success_seq = 0;
+
+	k_mutex_unlock(&profiles_lock);
+}
+
+size_t wifi_profiles_count(void)
+{
+	size_t count = 0;
+
+	k_mutex_lock(&profiles_lock, K_FOREVER);
+	for (size_t i = 0; i < WIFI_PROFILES_MAX; i++) {
+		if (profiles[i].ssid[0] != '\0') {
+			count++;
+		}
+	}
+	k_mutex_unlock(&profiles_lock);
+
+	return count;
+}
+
+int wifi_profiles_get(size_t slot, struct wifi_profile *profile)
+{
+	int rc = -ENOENT;
+
+	if (slot >= WIFI_PROFILES_MAX) {
+		return -ENOENT;
+	}
+
+	k_mutex_lock(&profiles_lock, K_FOREVER);
+	if (profiles[slot].ssid[0] != '\0') {
+		*profile = profiles[slot];
+		rc = 0;
+	}
+	k_mutex_unlock(&profiles_lock);
+
+	return rc;
+}
+
+/**
+ * @brief Score a profile; higher is more likely to connect quickly
+ *
+ * @param profile Profile to score
+ * @param rssi Strongest signal seen for its SSID, ignored if !seen
+ * @param seen Whether the SSID was in the scan
+ */
+static int wifi_profiles_score(const struct wifi_profile *profile, int rssi, bool seen)
+{
+	const struct wifi_profile_stats *stats = &profile->stats;
+	int score = 0;
+
+	if (seen) {
+		score += WIFI_PROFILES_SEEN_BONUS;
+		score += MAX(rssi - WIFI_PROFILES_RSSI_FLOOR, 0) * WIFI_PROFILES_RSSI_WEIGHT;
+	}
+
+	if (stats->last_success != 0) {
+		score += (stats->last_success == success_seq) ?
+		         WIFI_PROFILES_LAST_USED_BONUS : WIFI_PROFILES_KNOWN_BONUS;
+		score -= MIN(stats->avg_connect_ms / WIFI_PROFILES_SLOW_PENALTY_MS, 100U);
+	}
+
+	score -= MIN(stats->fail_streak, WIFI_PROFILES_FAIL_MAX) * WIFI_PROFILES_FAIL_PENALTY;
+
+	return score;
+}
+
+size_t wifi_profiles_rank(const struct wifi_scan_snapshot *scan,
+                          uint8_t *order, size_t max)
+{
+	int score[WIFI_PROFILES_MAX];
+	size_t n = 0;
+
+	k_mutex_lock(&profiles_lock, K_FOREVER);
+
+	for (size_t i = 0; i < WIFI_PROFILES_MAX && n < max; i++) {
+		const struct wifi_profile *profile = &profiles[i];
+		int rssi = WIFI_PROFILES_RSSI_FLOOR;
+		bool seen = false;
+		size_t pos;
+
+		if (profile->ssid[0] == '\0') {
+			continue;
+		}
+
+		/* One entry per SSID, already the strongest access point */
+		for (size_t r = 0; scan && r < scan->count; r++) {
+			if (strcmp(wifi_scanner_entry_ssid(scan, r), profile->ssid) == 0) {
+				rssi = scan->entries[r].rssi;
+				seen = true;
+				break;
+			}
+		}
+
+		/* Insertion sort, the list is tiny */
+		score[i] = wifi_profiles_score(profile, rssi, seen);
+		for (pos = n; pos > 0 && score[order[pos - 1]] < score[i]; pos--) {
+			order[pos] = order[pos - 1];
+		}
+		order[pos] = i;
+		n++;
+	}
+
+	k_mutex_unlock(&profiles_lock);
+
+	return n;
+}
+
+void wifi_profiles_report(size_t slot, int status, uint32_t connect_ms)
+{
+	struct wifi_profile_stats *stats;
+
+	if (slot >= WIFI_PROFILES_MAX) {
+		return;
+	}
+
+	k_mutex_lock(&profiles_lock, K_FOREVER);
+
+	if (profiles[slot].ssid[0] == '\0') {
+		k_mutex_unlock(&profiles_lock);
+		return;
+	}
+
+	stats = &profiles[slot].stats;
+
+	if (status == 0) {
+		/* Average over roughly the last four connects */
+		stats->avg_connect_ms = stats->successes == 0 ? connect_ms :
+		                        (3 * stats->avg_connect_ms + connect_ms) / 4;
+		if (stats->successes < UINT16_MAX) {
+			stats->successes++;
+		}
+		stats->fail_streak = 0;
+		stats->last_success = ++success_seq;
+	} else {
+		if (stats->failures < UINT16_MAX) {
+			stats->failures++;
+		}
+		if (stats->fail_streak < UINT8_MAX) {
+			stats->fail_streak++;
+		}
+	}
+
+	wifi_profiles_save(slot);
+
+	k_mutex_unlock(&profiles_lock);
+}
+
+/*
+ * Settings handler: Set (called for each "profiles/<slot>" record)
+ */
+static int wifi_profiles_handle_set(const char *name, size_t len,
+                                    settings_read_cb read_cb, void *cb_arg)
+{
+	struct wifi_profile profile;
+	unsigned long slot;
+	char *end;
+	ssize_t rc;
+
+	slot = strtoul(name, &end, 10);
+	if (end == name || *end != '\0') {
+		return -ENOENT;
+	}
+
+	if (len != sizeof(profile) || slot >= WIFI_PROFILES_MAX) {
+		LOG_WRN("Ignoring stored profile %s", name);
+		return 0;
+	}
+
+	rc = read_cb(cb_arg, &profile, sizeof(profile));
+	if (rc < 0) {
+		return rc;
+	}
+
+	profile.ssid[WIFI_SSID_MAX_LEN] = '\0';
+	profile.psk[WIFI_PSK_MAX_LEN] = '\0';
+
+	k_mutex_lock(&profiles_lock, K_FOREVER);
+	profiles[slot] = profile;
+	success_seq = MAX(success_seq, profile.stats.last_success);
+	k_mutex_unlock(&profiles_lock);
+
+	return 0;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(wifi_profiles_handler, "profiles",
+                               NULL,                      /* h_get */
+                               wifi_profiles_handle_set,  /* h_set */
+                               NULL,                      /* h_commit */
+                               NULL);                     /* h_export */
@@ -0,0 +1,120 @@
+/**
+ * @file wifi_profiles.h
+ * @brief Stored WiFi network profiles
+ *
+ * Keeps credentials for up to CONFIG_SLIDER_WIFI_MAX_PROFILES networks
+ * (for example studio, home and a phone hotspot) together with how
+ * connecting to each has gone: when it last succeeded, how long it
+ * usually takes and how often it failed.
+ *
+ * Before connecting, the profiles are ranked against a scan so the most
+ * likely network is tried first. Networks missing from the scan are
+ * still tried, after the ones seen: hidden networks never show up by
+ * name, and a crowded scan may have dropped a weak one.
+ *
+ * Each profile is persisted under "profiles/<slot>".
+ */
+
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <zephyr/net/wifi_mgmt.h>
+#include <stdbool.h>
+#include "wifi_scanner.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Number of profiles kept */
+#define WIFI_PROFILES_MAX CONFIG_SLIDER_WIFI_MAX_PROFILES
+
+/**
+ * @brief Connection history of a profile
+ */
+struct wifi_profile_stats {
+	uint32_t last_success;  /**< Success sequence number, 0 if never */
+	uint32_t avg_connect_ms;  /**< Moving average of successful connects */
+	uint16_t successes;
+	uint16_t failures;      /**< Failed connects, total */
+	uint8_t fail_streak;    /**< Failures since the last success */
+};
+
+/**
+ * @brief Stored network
+ */
+struct wifi_profile {
+	char ssid[WIFI_SSID_MAX_LEN + 1];  /**< Empty for an unused slot */
+	char psk[WIFI_PSK_MAX_LEN + 1];
+	struct wifi_profile_stats stats;
+};
+
+/**
+ * @brief Add a profile or update its passphrase
+ *
+ * When the store is full, the profile that has gone longest without a
+ * successful connect is replaced.
+ *
+ * @param ssid Network name
+ * @param psk Passphrase, empty for an open network
+ * @return Slot of the profile, or negative errno on failure
+ */
+int wifi_profiles_add(const char *ssid, const char *psk);
+
+/**
+ * @brief Remove a profile
+ *
+ * @param ssid Network name
+ * @return 0 on success, -ENOENT if no profile has that SSID
+ */
+int wifi_profiles_remove(const char *ssid);
+
+/**
+ * @brief Remove all profiles
+ */
+void wifi_profiles_clear(void);
+
+/**
+ * @brief Get the number of stored profiles
+ *
+ * @return Number of slots in use
+ */
+size_t wifi_profiles_count(void);
+
+/**
+ * @brief Copy a profile out of the store
+ *
+ * @param slot Slot, 0 to WIFI_PROFILES_MAX - 1
+ * @param profile Output profile
+ * @return 0 on success, -ENOENT if the slot is unused
+ */
+int wifi_profiles_get(size_t slot, struct wifi_profile *profile);
+
+/**
+ * @brief Order profiles by how likely a connect is to succeed
+ *
+ * Profiles seen in the scan come first, ranked by signal strength, how
+ * recently they connected, recent failures and usual connect time.
+ * Profiles not seen follow, ranked on their history alone, as are all
+ * profiles when @p scan is NULL (no scan available).
+ *
+ * @param scan Pinned scan results, or NULL
+ * @param order Output slots, best first
+ * @param max Size of order
+ * @return Number of slots written to order
+ */
+size_t wifi_profiles_rank(const struct wifi_scan_snapshot *scan,
+                          uint8_t *order, size_t max);
+
+/**
+ * @brief Record the outcome of a connect attempt
+ *
+ * @param slot Slot that was tried
+ * @param status 0 on success, negative errno on failure
+ * @param connect_ms Time from request to result
+ */
+void wifi_profiles_report(size_t slot, int status, uint32_t connect_ms);
+
+#ifdef __cplusplus
+}
+#endif
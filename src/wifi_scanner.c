@@ -11,74 +11,524 @@
 
 LOG_MODULE_REGISTER(wifi_scanner, LOG_LEVEL_INF);
 
+#define WIFI_SCANNER_DEFAULT_TIMEOUT_MS 10000
+
+/* Background refresh retry while the radio is busy */
+#define WIFI_SCANNER_BG_RETRY_MS 10000
+
+BUILD_ASSERT(WIFI_SECURITY_TYPE_UNKNOWN < 64 && WIFI_FREQ_BAND_UNKNOWN < 4,
+             "struct wifi_scan_entry bit fields too narrow");
+
+/* Wait between checks for a result callback still running */
+#define WIFI_SCANNER_CB_WAIT_MS 1
+
 /**
- * @brief WiFi scan result callback
+ * @brief Callbacks of one scan, captured under the lock
  *
- * Called by the WiFi subsystem for each discovered network
+ * The scan may end and a new one start while a notification is being
+ * delivered, so the callbacks are read once, not from the scanner.
  */
-static void wifi_scan_result_handler(struct net_mgmt_event_callback *cb,
-                                      uint64_t mgmt_event,
-                                      struct net_if *iface)
+struct wifi_scanner_req {
+	wifi_scanner_event_cb_t cb;
+	void *user_data;
+	bool targeted;
+};
+
+/**
+ * @brief Capture the callbacks of the current scan; lock held
+ */
+static void wifi_scanner_req_get(const struct wifi_scanner *scanner,
+                                 struct wifi_scanner_req *req)
 {
-	struct wifi_scanner *scanner = CONTAINER_OF(cb, struct wifi_scanner, scan_cb);
-	const struct wifi_scan_result *entry = (const struct wifi_scan_result *)cb->info;
+	req->cb = scanner->scan_req_cb;
+	req->user_data = scanner->scan_req_user_data;
+	req->targeted = scanner->scan_targeted;
+}
+
+/**
+ * @brief Notify the registered and the per-scan callbacks
+ *
+ * Targeted scans are private to whoever started them, so only their own
+ * callback hears of them.
+ */
+static void wifi_scanner_notify(struct wifi_scanner *scanner,
+                                const struct wifi_scanner_req *req,
+                                enum wifi_scanner_event event,
+                                const struct wifi_scan_result *result,
+                                int status)
+{
+	if (scanner->event_cb && !req->targeted) {
+		scanner->event_cb(event, result, status, scanner->event_user_data);
+	}
+
+	if (req->cb) {
+		req->cb(event, result, status, req->user_data);
+	}
+}
+
+/**
+ * @brief Get the buffer scans are written to
+ *
+ * Only the scanning side changes which snapshot is published, so the
+ * other one is stable in its context.
+ */
+static struct wifi_scan_snapshot *wifi_scanner_back(struct wifi_scanner *scanner)
+{
+	return &scanner->snaps[!atomic_get(&scanner->current)];
+}
+
+/**
+ * @brief Make the back buffer the published snapshot
+ */
+static void wifi_scanner_publish(struct wifi_scanner *scanner)
+{
+	struct wifi_scan_snapshot *back = wifi_scanner_back(scanner);
+
+	back->generation = ++scanner->generation;
+	atomic_set(&scanner->current, back - scanner->snaps);
+}
+
+/**
+ * @brief Find the entry a network duplicates
+ *
+ * Access points of one network (mesh nodes, repeaters) share the SSID
+ * and are listed once; hidden networks are told apart by BSSID.
+ *
+ * @param snap Snapshot to search
+ * @param ssid SSID, not terminated
+ * @param len SSID length, 0 for a hidden network
+ * @param bssid BSSID, or NULL if unknown
+ * @return Index of the duplicate, or -ENOENT
+ */
+static int wifi_scanner_find_dup(const struct wifi_scan_snapshot *snap,
+                                 const uint8_t *ssid, uint8_t len,
+                                 const uint8_t *bssid)
+{
+	for (size_t i = 0; i < snap->count; i++) {
+		const struct wifi_scan_entry *e = &snap->entries[i];
+		const uint8_t *e_ssid = &snap->ssid_pool[e->ssid];
+
+		if (len > 0) {
+			if (e_ssid[0] == len && memcmp(&e_ssid[1], ssid, len) == 0) {
+				return i;
+			}
+		} else if (e_ssid[0] == 0 && bssid &&
+		           memcmp(e->bssid, bssid, WIFI_MAC_ADDR_LEN) == 0) {
+			return i;
+		}
+	}
+
+	return -ENOENT;
+}
+
+/**
+ * @brief Take an entry out of the order, keeping its SSID
+ */
+static void wifi_scanner_unlink(struct wifi_scan_snapshot *snap, size_t index)
+{
+	snap->count--;
+	memmove(&snap->entries[index], &snap->entries[index + 1],
+	        (snap->count - index) * sizeof(snap->entries[0]));
+}
+
+/**
+ * @brief Remove an entry and free its SSID
+ *
+ * The pool is kept contiguous, so later SSIDs move down.
+ */
+static void wifi_scanner_drop(struct wifi_scan_snapshot *snap, size_t index)
+{
+	uint16_t off = snap->entries[index].ssid;
+	uint16_t size = snap->ssid_pool[off] + 2;
+
+	wifi_scanner_unlink(snap, index);
+
+	memmove(&snap->ssid_pool[off], &snap->ssid_pool[off + size],
+	        snap->pool_used - off - size);
+	snap->pool_used -= size;
+
+	for (size_t i = 0; i < snap->count; i++) {
+		if (snap->entries[i].ssid > off) {
+			snap->entries[i].ssid -= size;
+		}
+	}
+}
+
+/**
+ * @brief Copy an SSID into the pool; the caller makes room
+ *
+ * @return Offset of the SSID
+ */
+static uint16_t wifi_scanner_pool_add(struct wifi_scan_snapshot *snap,
+                                      const uint8_t *ssid, uint8_t len)
+{
+	uint16_t off = snap->pool_used;
+
+	snap->ssid_pool[off] = len;
+	memcpy(&snap->ssid_pool[off + 1], ssid, len);
+	snap->ssid_pool[off + 1 + len] = '\0';
+	snap->pool_used += len + 2;
+
+	return off;
+}
+
+/**
+ * @brief Insert an entry at its place, strongest first
+ *
+ * The caller makes room. The position is found by binary search; among
+ * equal signals the earlier result stays first.
+ *
+ * @return Index of the new entry
+ */
+static size_t wifi_scanner_insert(struct wifi_scan_snapshot *snap,
+                                  const struct wifi_scan_entry *entry)
+{
+	size_t lo = 0;
+	size_t hi = snap->count;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+
+		if (snap->entries[mid].rssi >= entry->rssi) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	memmove(&snap->entries[lo + 1], &snap->entries[lo],
+	        (snap->count - lo) * sizeof(snap->entries[0]));
+	snap->entries[lo] = *entry;
+	snap->count++;
 
-	if (mgmt_event != NET_EVENT_WIFI_SCAN_RESULT) {
+	return lo;
+}
+
+/**
+ * @brief Keep recently seen networks the new scan missed
+ *
+ * Copies them over from the published snapshot with their age, as long
+ * as there is room; networks seen just now are never evicted for them.
+ * Called without the lock while the scan is finishing, when nothing
+ * else writes the back buffer.
+ */
+static void wifi_scanner_carry_over(struct wifi_scanner *scanner,
+                                    struct wifi_scan_snapshot *back)
+{
+	const struct wifi_scan_snapshot *cur = &scanner->snaps[atomic_get(&scanner->current)];
+	uint32_t elapsed_s;
+
+	if (cur->timestamp == 0) {
 		return;
 	}
 
-	/* Check if we have space for more results */
-	if (scanner->result_count >= WIFI_SCANNER_MAX_RESULTS) {
-		LOG_WRN("Scan result buffer full, ignoring result");
+	elapsed_s = (uint32_t)((back->timestamp - cur->timestamp) / 1000);
+
+	for (size_t i = 0; i < cur->count; i++) {
+		struct wifi_scan_entry entry = cur->entries[i];
+		const uint8_t *ssid = &cur->ssid_pool[entry.ssid];
+		uint32_t age_s = entry.age_s + elapsed_s;
+
+		if (age_s > CONFIG_SLIDER_WIFI_SCAN_KEEP_S ||
+		    back->count >= WIFI_SCANNER_MAX_RESULTS ||
+		    back->pool_used + ssid[0] + 2 > WIFI_SCANNER_SSID_POOL_SIZE ||
+		    wifi_scanner_find_dup(back, &ssid[1], ssid[0], entry.bssid) >= 0) {
+			continue;
+		}
+
+		entry.age_s = age_s;
+		entry.ssid = wifi_scanner_pool_add(back, &ssid[1], ssid[0]);
+		wifi_scanner_insert(back, &entry);
+	}
+}
+
+/**
+ * @brief End the current scan
+ *
+ * Called on the driver's done event and on timeout; whichever comes
+ * second finds the scan already ended and does nothing.
+ */
+static void wifi_scanner_finish(struct wifi_scanner *scanner, int status)
+{
+	k_spinlock_key_t key = k_spin_lock(&scanner->lock);
+	struct wifi_scan_snapshot *back;
+	struct wifi_scanner_req req;
+	size_t count = 0;
+	bool publish;
+
+	if (scanner->state != WIFI_SCANNER_SCANNING || scanner->scan_finishing) {
+		k_spin_unlock(&scanner->lock, key);
 		return;
 	}
 
-	/* Copy the scan result */
-	struct wifi_scan_result *result = &scanner->results[scanner->result_count];
-	memcpy(result, entry, sizeof(struct wifi_scan_result));
+	/* Results are dropped from now on, and the state still turns new
+	 * scans away, so the back buffer is left to this call
+	 */
+	scanner->scan_finishing = true;
+	publish = status == 0 && !scanner->scan_targeted;
+	k_spin_unlock(&scanner->lock, key);
+
+	/* The merge moves entries around; it runs with interrupts enabled */
+	if (publish) {
+		back = wifi_scanner_back(scanner);
+		back->timestamp = k_uptime_get();
+		wifi_scanner_carry_over(scanner, back);
+		count = back->count;
+	}
+
+	key = k_spin_lock(&scanner->lock);
+
+	/* Published before a new scan can claim the buffer */
+	if (publish) {
+		wifi_scanner_publish(scanner);
+	}
 
-	/* Ensure SSID is null-terminated */
-	if (result->ssid_length < WIFI_SSID_MAX_LEN) {
-		result->ssid[result->ssid_length] = '\0';
+	scanner->scan_finishing = false;
+	scanner->state = (status == 0) ? WIFI_SCANNER_COMPLETE : WIFI_SCANNER_FAILED;
+	scanner->scan_status = status;
+
+	/* Taken now: a scan started from the EVT_DONE callback sets its own */
+	wifi_scanner_req_get(scanner, &req);
+	scanner->scan_req_cb = NULL;
+
+	/* No result callback starts once the state has changed. One already
+	 * running may still use what EVT_DONE lets its owner release, so it
+	 * is waited for, unless it is what ended the scan.
+	 */
+	while (scanner->cb_thread && scanner->cb_thread != k_current_get()) {
+		k_spin_unlock(&scanner->lock, key);
+		k_sleep(K_MSEC(WIFI_SCANNER_CB_WAIT_MS));
+		key = k_spin_lock(&scanner->lock);
+	}
+	k_spin_unlock(&scanner->lock, key);
+
+	k_work_cancel_delayable(&scanner->timeout_work);
+
+	if (status == 0 && req.targeted) {
+		LOG_INF("Targeted WiFi scan completed");
+	} else if (status == 0) {
+		LOG_INF("WiFi scan completed, listing %zu networks", count);
 	} else {
-		result->ssid[WIFI_SSID_MAX_LEN] = '\0';
+		LOG_ERR("WiFi scan failed with status: %d", status);
 	}
 
-	scanner->result_count++;
+	wifi_scanner_notify(scanner, &req, WIFI_SCANNER_EVT_DONE, NULL, status);
+
+	/* Signal completion */
+	k_sem_give(&scanner->scan_sem);
+}
+
+static void wifi_scanner_timeout(struct k_work *work)
+{
+	struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+	struct wifi_scanner *scanner = CONTAINER_OF(dwork, struct wifi_scanner, timeout_work);
 
-	LOG_DBG("Scan result #%zu: SSID=%s, RSSI=%d, Channel=%u, Security=%u",
-	        scanner->result_count, result->ssid, result->rssi,
-	        result->channel, result->security);
+	LOG_ERR("WiFi scan timeout");
+	wifi_scanner_finish(scanner, -ETIMEDOUT);
 }
 
 /**
- * @brief WiFi scan done callback
+ * @brief Check whether a scan would disturb nothing
  *
- * Called when the scan completes or fails
+ * A station joining a network must not be interrupted, and an access
+ * point cannot scan without taking its clients off channel.
  */
-static void wifi_scan_done_handler(struct net_mgmt_event_callback *cb,
-                                    uint64_t mgmt_event,
-                                    struct net_if *iface)
+static bool wifi_scanner_radio_idle(void)
 {
-	struct wifi_scanner *scanner = CONTAINER_OF(cb, struct wifi_scanner, scan_cb);
-	const struct wifi_status *status = (const struct wifi_status *)cb->info;
+	struct net_if *iface = net_if_get_default();
+	struct wifi_iface_status status = {0};
+
+	if (!iface || net_mgmt(NET_REQUEST_WIFI_IFACE_STATUS, iface, &status,
+	                       sizeof(status))) {
+		return false;
+	}
+
+	if (status.iface_mode == WIFI_MODE_AP) {
+		return false;
+	}
+
+	return status.state == WIFI_STATE_DISCONNECTED ||
+	       status.state == WIFI_STATE_INACTIVE ||
+	       status.state == WIFI_STATE_COMPLETED;
+}
+
+static void wifi_scanner_bg_work(struct k_work *work)
+{
+	struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+	struct wifi_scanner *scanner = CONTAINER_OF(dwork, struct wifi_scanner, bg_work);
+	const struct wifi_scan_snapshot *snap;
+	uint32_t interval = scanner->bg_interval_ms;
+	uint32_t age;
+
+	if (interval == 0) {
+		return;
+	}
+
+	snap = wifi_scanner_snapshot_get(scanner);
+	age = wifi_scanner_snapshot_age_ms(snap);
+	wifi_scanner_snapshot_put(snap);
+
+	if (age < interval) {
+		k_work_reschedule(&scanner->bg_work, K_MSEC(interval - age));
+		return;
+	}
 
-	if (mgmt_event != NET_EVENT_WIFI_SCAN_DONE) {
+	if (scanner->state == WIFI_SCANNER_SCANNING || !wifi_scanner_radio_idle() ||
+	    wifi_scanner_scan_async(scanner, 0, NULL, NULL) != 0) {
+		k_work_reschedule(&scanner->bg_work, K_MSEC(WIFI_SCANNER_BG_RETRY_MS));
 		return;
 	}
 
-	if (status->status == 0) {
-		scanner->state = WIFI_SCANNER_COMPLETE;
-		scanner->scan_status = 0;
-		LOG_INF("WiFi scan completed, found %zu networks", scanner->result_count);
+	LOG_DBG("Background scan started");
+	k_work_reschedule(&scanner->bg_work, K_MSEC(interval));
+}
+
+/**
+ * @brief Mark a result callback as running; lock held
+ *
+ * wifi_scanner_finish() waits for it to end before EVT_DONE.
+ */
+static void wifi_scanner_result_begin(struct wifi_scanner *scanner,
+                                      struct wifi_scanner_req *req)
+{
+	wifi_scanner_req_get(scanner, req);
+	scanner->cb_thread = k_current_get();
+}
+
+/**
+ * @brief Mark the running result callback as ended
+ */
+static void wifi_scanner_result_end(struct wifi_scanner *scanner)
+{
+	k_spinlock_key_t key = k_spin_lock(&scanner->lock);
+
+	scanner->cb_thread = NULL;
+	k_spin_unlock(&scanner->lock, key);
+}
+
+/**
+ * @brief Handle a scan result
+ *
+ * Called by the WiFi subsystem for each discovered network
+ */
+static void wifi_scan_result_handler(struct wifi_scanner *scanner,
+                                     const struct wifi_scan_result *result)
+{
+	struct wifi_scan_snapshot *back;
+	struct wifi_scan_entry entry = {0};
+	struct wifi_scanner_req req;
+	uint8_t ssid_len;
+	k_spinlock_key_t key;
+	size_t pos;
+	int dup;
+
+	ssid_len = MIN(result->ssid_length, WIFI_SSID_MAX_LEN);
+
+	if (result->mac_length == WIFI_MAC_ADDR_LEN) {
+		memcpy(entry.bssid, result->mac, WIFI_MAC_ADDR_LEN);
+	}
+	entry.rssi = result->rssi;
+	entry.channel = result->channel;
+	entry.security = result->security;
+	entry.band = result->band;
+
+	/* Held so a timeout cannot publish the buffer mid-update */
+	key = k_spin_lock(&scanner->lock);
+
+	/* Late results of a scan that timed out or is finishing */
+	if (scanner->state != WIFI_SCANNER_SCANNING || scanner->scan_finishing) {
+		k_spin_unlock(&scanner->lock, key);
+		return;
+	}
+
+	if (scanner->scan_targeted) {
+		struct wifi_scan_result copy = *result;
+
+		wifi_scanner_result_begin(scanner, &req);
+		k_spin_unlock(&scanner->lock, key);
+
+		/* Every access point counts, the table is not involved */
+		copy.ssid_length = ssid_len;
+		copy.ssid[ssid_len] = '\0';
+		wifi_scanner_notify(scanner, &req, WIFI_SCANNER_EVT_RESULT, &copy, 0);
+		wifi_scanner_result_end(scanner);
+		return;
+	}
+
+	back = wifi_scanner_back(scanner);
+
+	dup = wifi_scanner_find_dup(back, result->ssid, ssid_len,
+	                            result->mac_length == WIFI_MAC_ADDR_LEN ?
+	                            result->mac : NULL);
+	if (dup >= 0) {
+		if (entry.rssi <= back->entries[dup].rssi) {
+			k_spin_unlock(&scanner->lock, key);
+			return;
+		}
+		/* Stronger access point of a known network; it moves up */
+		entry.ssid = back->entries[dup].ssid;
+		wifi_scanner_unlink(back, dup);
 	} else {
-		scanner->state = WIFI_SCANNER_FAILED;
-		scanner->scan_status = status->status;
-		LOG_ERR("WiFi scan failed with status: %d", status->status);
+		/* Make room in the table and the pool at the weakest's expense */
+		while (back->count >= WIFI_SCANNER_MAX_RESULTS ||
+		       back->pool_used + ssid_len + 2 > WIFI_SCANNER_SSID_POOL_SIZE) {
+			if (entry.rssi <= back->entries[back->count - 1].rssi) {
+				k_spin_unlock(&scanner->lock, key);
+				LOG_DBG("Scan table full, dropping weaker result");
+				return;
+			}
+			wifi_scanner_drop(back, back->count - 1);
+		}
+		entry.ssid = wifi_scanner_pool_add(back, result->ssid, ssid_len);
 	}
 
-	/* Signal completion */
-	k_sem_give(&scanner->scan_sem);
+	pos = wifi_scanner_insert(back, &entry);
+
+	if (dup < 0) {
+		wifi_scanner_result_begin(scanner, &req);
+	}
+	k_spin_unlock(&scanner->lock, key);
+
+	LOG_DBG("Scan result #%zu: SSID=%.*s, RSSI=%d, Channel=%u, Security=%u",
+	        pos, ssid_len, result->ssid, result->rssi, result->channel,
+	        result->security);
+
+	/* Only new networks are announced, not better signals of known ones */
+	if (dup < 0) {
+		struct wifi_scan_result copy = *result;
+
+		copy.ssid_length = ssid_len;
+		copy.ssid[ssid_len] = '\0';
+		wifi_scanner_notify(scanner, &req, WIFI_SCANNER_EVT_RESULT, &copy, 0);
+		wifi_scanner_result_end(scanner);
+	}
+}
+
+/**
+ * @brief WiFi scan event callback
+ *
+ * One callback serves both events; a callback struct can only be
+ * registered once, with a single handler.
+ */
+static void wifi_scan_event_handler(struct net_mgmt_event_callback *cb,
+                                    uint64_t mgmt_event,
+                                    struct net_if *iface)
+{
+	struct wifi_scanner *scanner = CONTAINER_OF(cb, struct wifi_scanner, scan_cb);
+
+	ARG_UNUSED(iface);
+
+	switch (mgmt_event) {
+	case NET_EVENT_WIFI_SCAN_RESULT:
+		wifi_scan_result_handler(scanner, (const struct wifi_scan_result *)cb->info);
+		break;
+	case NET_EVENT_WIFI_SCAN_DONE:
+		/* Called when the scan completes or fails */
+		wifi_scanner_finish(scanner, ((const struct wifi_status *)cb->info)->status);
+		break;
+	default:
+		break;
+	}
 }
 
 int wifi_scanner_init(struct wifi_scanner *scanner)
@@ -91,16 +541,12 @@ int wifi_scanner_init(struct wifi_scanner *scanner)
 	memset(scanner, 0, sizeof(struct wifi_scanner));
 	scanner->state = WIFI_SCANNER_IDLE;
 	k_sem_init(&scanner->scan_sem, 0, 1);
+	k_work_init_delayable(&scanner->timeout_work, wifi_scanner_timeout);
+	k_work_init_delayable(&scanner->bg_work, wifi_scanner_bg_work);
 
 	/* Register scan callbacks */
 	net_mgmt_init_event_callback(&scanner->scan_cb,
-	                             wifi_scan_result_handler,
-	                             NET_EVENT_WIFI_SCAN_RESULT);
-	net_mgmt_add_event_callback(&scanner->scan_cb);
-
-	/* Note: We reuse the same callback struct but register for done event separately */
-	net_mgmt_init_event_callback(&scanner->scan_cb,
-	                             wifi_scan_done_handler,
+	                             wifi_scan_event_handler,
 	                             NET_EVENT_WIFI_SCAN_RESULT |
 	                             NET_EVENT_WIFI_SCAN_DONE);
 	net_mgmt_add_event_callback(&scanner->scan_cb);
@@ -109,20 +555,31 @@ int wifi_scanner_init(struct wifi_scanner *scanner)
 	return 0;
 }
 
-int wifi_scanner_scan(struct wifi_scanner *scanner, uint32_t timeout_ms)
+/**
+ * @brief Check whether a scan sees only part of the neighbourhood
+ */
+static bool wifi_scanner_params_targeted(const struct wifi_scan_params *params)
 {
+	return params && (params->bands != 0 || params->band_chan[0].channel != 0 ||
+	                  params->ssids[0] != NULL || params->max_bss_cnt != 0);
+}
+
+int wifi_scanner_scan_params_async(struct wifi_scanner *scanner,
+                                   const struct wifi_scan_params *params,
+                                   uint32_t timeout_ms,
+                                   wifi_scanner_event_cb_t cb, void *user_data)
+{
+	struct wifi_scan_snapshot *back;
+	struct wifi_scanner_req req;
 	struct net_if *iface;
+	k_spinlock_key_t key;
+	bool targeted;
 	int ret;
 
 	if (!scanner) {
 		return -EINVAL;
 	}
 
-	if (scanner->state == WIFI_SCANNER_SCANNING) {
-		LOG_WRN("Scan already in progress");
-		return -EBUSY;
-	}
-
 	/* Get network interface */
 	iface = net_if_get_default();
 	if (!iface) {
@@ -130,67 +587,243 @@ int wifi_scanner_scan(struct wifi_scanner *scanner, uint32_t timeout_ms)
 		return -ENODEV;
 	}
 
-	/* Clear previous results */
-	wifi_scanner_clear_results(scanner);
+	key = k_spin_lock(&scanner->lock);
+	if (scanner->state == WIFI_SCANNER_SCANNING) {
+		k_spin_unlock(&scanner->lock, key);
+		LOG_WRN("Scan already in progress");
+		return -EBUSY;
+	}
+
+	/* Targeted scans leave the back buffer alone */
+	targeted = wifi_scanner_params_targeted(params);
+	if (!targeted) {
+		/* A reader still holds the snapshot before last */
+		back = wifi_scanner_back(scanner);
+		if (atomic_get(&back->readers) != 0) {
+			k_spin_unlock(&scanner->lock, key);
+			LOG_WRN("Previous scan results still in use");
+			return -EBUSY;
+		}
+
+		back->count = 0;
+		back->pool_used = 0;
+	}
+
+	scanner->state = WIFI_SCANNER_SCANNING;
+	scanner->scan_targeted = targeted;
+	scanner->scan_status = 0;
+	scanner->scan_req_user_data = user_data;
+	scanner->scan_req_cb = cb;
+	wifi_scanner_req_get(scanner, &req);
+	k_spin_unlock(&scanner->lock, key);
 
 	/* Reset semaphore */
 	k_sem_reset(&scanner->scan_sem);
 
-	/* Update state */
-	scanner->state = WIFI_SCANNER_SCANNING;
-	scanner->scan_status = 0;
+	LOG_INF("Starting %sWiFi scan...", targeted ? "targeted " : "");
+
+	/* Results may arrive before net_mgmt() returns */
+	wifi_scanner_notify(scanner, &req, WIFI_SCANNER_EVT_STARTED, NULL, 0);
 
-	LOG_INF("Starting WiFi scan...");
+	if (timeout_ms == 0) {
+		timeout_ms = WIFI_SCANNER_DEFAULT_TIMEOUT_MS;
+	}
+	k_work_reschedule(&scanner->timeout_work, K_MSEC(timeout_ms));
 
 	/* Trigger scan */
-	ret = net_mgmt(NET_REQUEST_WIFI_SCAN, iface, NULL, 0);
+	ret = net_mgmt(NET_REQUEST_WIFI_SCAN, iface, (void *)params,
+	               params ? sizeof(*params) : 0);
 	if (ret) {
 		LOG_ERR("Failed to start WiFi scan: %d", ret);
-		scanner->state = WIFI_SCANNER_FAILED;
-		scanner->scan_status = ret;
+		/* The caller learns of this from the return value */
+		key = k_spin_lock(&scanner->lock);
+		scanner->scan_req_cb = NULL;
+		k_spin_unlock(&scanner->lock, key);
+		wifi_scanner_finish(scanner, ret);
 		return ret;
 	}
 
-	/* Wait for scan completion */
+	return 0;
+}
+
+int wifi_scanner_scan_async(struct wifi_scanner *scanner, uint32_t timeout_ms,
+                            wifi_scanner_event_cb_t cb, void *user_data)
+{
+	return wifi_scanner_scan_params_async(scanner, NULL, timeout_ms, cb, user_data);
+}
+
+void wifi_scanner_params_probe(struct wifi_scan_params *params, const char *ssid,
+                               enum wifi_frequency_bands band, uint8_t channel)
+{
+	memset(params, 0, sizeof(*params));
+	params->scan_type = WIFI_SCAN_TYPE_ACTIVE;
+	params->ssids[0] = ssid;
+
+	/* The channel list ends at the first zero channel */
+	params->band_chan[0].band = band;
+	params->band_chan[0].channel = channel;
+}
+
+int wifi_scanner_scan(struct wifi_scanner *scanner, uint32_t timeout_ms)
+{
+	int ret;
+
 	if (timeout_ms == 0) {
-		timeout_ms = 10000; /* Default 10 second timeout */
+		timeout_ms = WIFI_SCANNER_DEFAULT_TIMEOUT_MS;
+	}
+
+	ret = wifi_scanner_scan_async(scanner, timeout_ms, NULL, NULL);
+	if (ret) {
+		return ret;
 	}
 
-	ret = k_sem_take(&scanner->scan_sem, K_MSEC(timeout_ms));
-	if (ret == -EAGAIN) {
-		LOG_ERR("WiFi scan timeout");
-		scanner->state = WIFI_SCANNER_FAILED;
-		scanner->scan_status = -ETIMEDOUT;
-		return -ETIMEDOUT;
+	/* Normally ended by the driver or the timeout work; the margin only
+	 * matters if the system work queue is stuck
+	 */
+	if (k_sem_take(&scanner->scan_sem, K_MSEC(timeout_ms + 1000)) == -EAGAIN) {
+		wifi_scanner_finish(scanner, -ETIMEDOUT);
+		/* Given by this finish, or by one already merging results */
+		(void)k_sem_take(&scanner->scan_sem, K_FOREVER);
 	}
 
 	/* Return scan status */
-	if (scanner->scan_status != 0) {
-		return scanner->scan_status;
+	return scanner->scan_status;
+}
+
+void wifi_scanner_set_event_cb(struct wifi_scanner *scanner,
+                               wifi_scanner_event_cb_t cb, void *user_data)
+{
+	if (!scanner) {
+		return;
 	}
 
-	return 0;
+	scanner->event_user_data = user_data;
+	scanner->event_cb = cb;
 }
 
-const struct wifi_scan_result *wifi_scanner_get_results(
-	struct wifi_scanner *scanner, size_t *count)
+const struct wifi_scan_snapshot *wifi_scanner_snapshot_get(struct wifi_scanner *scanner)
 {
-	if (!scanner || !count) {
-		return NULL;
+	struct wifi_scan_snapshot *snap;
+	atomic_val_t cur;
+
+	for (;;) {
+		cur = atomic_get(&scanner->current);
+		snap = &scanner->snaps[cur];
+		atomic_inc(&snap->readers);
+
+		/* Still published, so the scan side will see the pin before
+		 * reusing it; otherwise it may be refilling it already
+		 */
+		if (atomic_get(&scanner->current) == cur) {
+			return snap;
+		}
+
+		atomic_dec(&snap->readers);
 	}
+}
 
-	*count = scanner->result_count;
-	return scanner->results;
+const struct wifi_scan_snapshot *wifi_scanner_snapshot_get_fresh(struct wifi_scanner *scanner,
+                                                                 uint32_t max_age_ms)
+{
+	const struct wifi_scan_snapshot *snap = wifi_scanner_snapshot_get(scanner);
+
+	if (wifi_scanner_snapshot_age_ms(snap) > max_age_ms &&
+	    scanner->state != WIFI_SCANNER_SCANNING) {
+		/* Published later; the caller keeps what it has meanwhile */
+		(void)wifi_scanner_scan_async(scanner, 0, NULL, NULL);
+	}
+
+	return snap;
 }
 
-void wifi_scanner_clear_results(struct wifi_scanner *scanner)
+uint32_t wifi_scanner_snapshot_age_ms(const struct wifi_scan_snapshot *snap)
+{
+	int64_t age;
+
+	if (!snap || snap->timestamp == 0) {
+		return UINT32_MAX;
+	}
+
+	age = k_uptime_get() - snap->timestamp;
+	return (uint32_t)MIN(age, UINT32_MAX);
+}
+
+uint32_t wifi_scanner_entry_age_s(const struct wifi_scan_snapshot *snap, size_t index)
+{
+	uint32_t age_ms = wifi_scanner_snapshot_age_ms(snap);
+
+	if (age_ms == UINT32_MAX || index >= snap->count) {
+		return UINT32_MAX;
+	}
+
+	return age_ms / 1000 + snap->entries[index].age_s;
+}
+
+const char *wifi_scanner_entry_ssid(const struct wifi_scan_snapshot *snap, size_t index)
+{
+	if (!snap || index >= snap->count) {
+		return "";
+	}
+
+	return (const char *)&snap->ssid_pool[snap->entries[index].ssid + 1];
+}
+
+void wifi_scanner_snapshot_put(const struct wifi_scan_snapshot *snap)
+{
+	if (snap) {
+		atomic_dec((atomic_t *)&snap->readers);
+	}
+}
+
+int wifi_scanner_clear_results(struct wifi_scanner *scanner)
+{
+	struct wifi_scan_snapshot *back;
+	k_spinlock_key_t key;
+	int rc = -EBUSY;
+
+	if (!scanner) {
+		return -EINVAL;
+	}
+
+	key = k_spin_lock(&scanner->lock);
+
+	back = wifi_scanner_back(scanner);
+	if (scanner->state != WIFI_SCANNER_SCANNING &&
+	    atomic_get(&back->readers) == 0) {
+		back->count = 0;
+		back->pool_used = 0;
+		back->timestamp = 0;
+		wifi_scanner_publish(scanner);
+		rc = 0;
+	}
+
+	k_spin_unlock(&scanner->lock, key);
+
+	return rc;
+}
+
+void wifi_scanner_set_background(struct wifi_scanner *scanner, uint32_t interval_ms)
 {
 	if (!scanner) {
 		return;
 	}
 
-	memset(scanner->results, 0, sizeof(scanner->results));
-	scanner->result_count = 0;
+	scanner->bg_interval_ms = interval_ms;
+
+	if (interval_ms) {
+		k_work_reschedule(&scanner->bg_work, K_NO_WAIT);
+	} else {
+		k_work_cancel_delayable(&scanner->bg_work);
+	}
+}
+
+uint32_t wifi_scanner_get_generation(struct wifi_scanner *scanner)
+{
+	if (!scanner) {
+		return 0;
+	}
+
+	return scanner->generation;
 }
 
 enum wifi_scanner_state wifi_scanner_get_state(struct wifi_scanner *scanner)
@@ -5,6 +5,29 @@
  * This module provides WiFi network scanning functionality, allowing
  * discovery of available access points with their signal strengths,
  * security types, and other properties.
+ *
+ * Results are kept strongest first, with one entry per network: of the
+ * access points sharing an SSID only the strongest is listed, and hidden
+ * networks are told apart by BSSID.
+ *
+ * Readers never see a scan half done. A scan fills a back buffer while
+ * readers keep using the last published snapshot; a successful scan then
+ * publishes its buffer in one atomic swap. Readers pin the snapshot they
+ * use without taking a lock, and a new scan does not start while the
+ * buffer it would overwrite is still pinned.
+ *
+ * A network missing from one scan stays listed for
+ * CONFIG_SLIDER_WIFI_SCAN_KEEP_S, stamped with when it was last seen.
+ * Callers that can live with older results take the published snapshot
+ * at once and, past the age they accept, have a refresh started in the
+ * background; see wifi_scanner_snapshot_get_fresh(). Optionally the
+ * scanner also refreshes on its own schedule while the radio is idle.
+ *
+ * Scans may be narrowed to some channels, passive listening, dwell times
+ * and SSIDs through struct wifi_scan_params. Such targeted scans, like a
+ * probe of one channel for a known network, report what they find
+ * through the progress callback only and leave the published results to
+ * full scans.
  */
 
 #pragma once
@@ -16,12 +39,36 @@
 extern "C" {
 #endif
 
-/** Maximum number of scan results to store */
+/**
+ * Maximum number of scan results to store. When more networks are in
+ * range, the weakest are dropped.
+ */
 #define WIFI_SCANNER_MAX_RESULTS 32
 
-/* Note: We use the wifi_scan_result struct from Zephyr's wifi_mgmt.h
- * instead of defining our own to avoid conflicts. The Zephyr struct
- * already provides all necessary fields. */
+/**
+ * Space for the SSIDs of one snapshot. Each takes its length plus two
+ * bytes, so this fits 32 SSIDs of 14 characters; when it runs out, the
+ * weakest networks are dropped as for a full table.
+ */
+#define WIFI_SCANNER_SSID_POOL_SIZE 512
+
+/**
+ * @brief Stored scan result
+ *
+ * Zephyr's struct wifi_scan_result carries a fixed SSID buffer and
+ * fields the application never reads. Results are stored in this packed
+ * form instead, with the SSID in the snapshot's pool; read it with
+ * wifi_scanner_entry_ssid().
+ */
+struct wifi_scan_entry {
+	uint8_t bssid[WIFI_MAC_ADDR_LEN];
+	int8_t rssi;            /**< Signal strength in dBm */
+	uint8_t channel;
+	uint8_t security : 6;   /**< enum wifi_security_type */
+	uint8_t band : 2;       /**< enum wifi_frequency_bands */
+	uint16_t ssid;          /**< Offset of the SSID in the pool */
+	uint16_t age_s;         /**< Time since last seen, as of the snapshot */
+} __packed;
 
 /**
  * @brief WiFi scanner state
@@ -33,18 +80,71 @@ enum wifi_scanner_state {
 	WIFI_SCANNER_FAILED     /**< Scan failed */
 };
 
+/**
+ * @brief Scan progress notifications
+ */
+enum wifi_scanner_event {
+	WIFI_SCANNER_EVT_STARTED,   /**< Scan request accepted by the driver */
+	WIFI_SCANNER_EVT_RESULT,    /**< New network listed, or any find of a targeted scan */
+	WIFI_SCANNER_EVT_DONE       /**< Scan finished (status 0) or failed */
+};
+
+/**
+ * @brief Scan progress callback
+ *
+ * Runs in the network management thread, the system work queue (scan
+ * timeout) or the thread starting the scan, and must not block.
+ *
+ * @param event Notification type
+ * @param result New result for EVT_RESULT, otherwise NULL; only valid
+ *               during the call
+ * @param status Scan status for EVT_DONE, otherwise 0
+ * @param user_data User data pointer
+ */
+typedef void (*wifi_scanner_event_cb_t)(enum wifi_scanner_event event,
+                                        const struct wifi_scan_result *result,
+                                        int status, void *user_data);
+
+/**
+ * @brief Result set of one completed scan
+ *
+ * Immutable once published.
+ */
+struct wifi_scan_snapshot {
+	struct wifi_scan_entry entries[WIFI_SCANNER_MAX_RESULTS];  /**< Strongest first */
+	/** SSIDs as a length byte, the SSID and a terminating NUL */
+	uint8_t ssid_pool[WIFI_SCANNER_SSID_POOL_SIZE];
+	uint16_t pool_used;
+	size_t count;
+	int64_t timestamp;      /**< Uptime the scan completed (ms), 0 if never */
+	uint32_t generation;
+	atomic_t readers;       /**< Pins held by readers */
+};
+
 /**
  * @brief WiFi scanner context
  *
  * Manages scan state and results
  */
 struct wifi_scanner {
-	struct wifi_scan_result results[WIFI_SCANNER_MAX_RESULTS];
-	size_t result_count;
+	struct wifi_scan_snapshot snaps[2];
+	atomic_t current;       /**< Index of the published snapshot */
 	enum wifi_scanner_state state;
 	struct k_sem scan_sem;
 	struct net_mgmt_event_callback scan_cb;
 	int scan_status;
+	uint32_t generation;    /**< Generation of the published snapshot */
+	wifi_scanner_event_cb_t event_cb;
+	void *event_user_data;
+	wifi_scanner_event_cb_t scan_req_cb;   /**< Callback of the current scan */
+	void *scan_req_user_data;
+	struct k_work_delayable timeout_work;  /**< Ends a scan the driver never finishes */
+	struct k_work_delayable bg_work;       /**< Background refresh */
+	uint32_t bg_interval_ms;               /**< 0 when background scanning is off */
+	bool scan_targeted;                    /**< Current scan publishes nothing */
+	bool scan_finishing;                   /**< Scan ended, results being merged */
+	k_tid_t cb_thread;                     /**< Thread in a result callback, or NULL */
+	struct k_spinlock lock;                /**< Serializes the end of a scan */
 };
 
 /**
@@ -70,21 +170,181 @@ int wifi_scanner_init(struct wifi_scanner *scanner);
 int wifi_scanner_scan(struct wifi_scanner *scanner, uint32_t timeout_ms);
 
 /**
- * @brief Get scan results
+ * @brief Start a WiFi network scan without waiting for it
+ *
+ * Returns once the driver has accepted the request. @p cb then receives
+ * EVT_RESULT for each network as the driver reports it and a final
+ * EVT_DONE, which also ends the scan with -ETIMEDOUT if the driver has
+ * not finished within @p timeout_ms. The callback registered with
+ * wifi_scanner_set_event_cb() is notified as well. Readers see the new
+ * results from EVT_DONE on; a failed scan leaves the previous ones.
+ *
+ * @param scanner Pointer to scanner context
+ * @param timeout_ms Timeout in milliseconds (0 = use default 10s)
+ * @param cb Progress callback for this scan only, or NULL
+ * @param user_data User data passed to cb
+ * @return 0 if the scan started, -EBUSY if one is in progress or the
+ *         back buffer is still pinned, other negative errno on failure
+ *         (cb then gets no EVT_DONE)
+ */
+int wifi_scanner_scan_async(struct wifi_scanner *scanner, uint32_t timeout_ms,
+                            wifi_scanner_event_cb_t cb, void *user_data);
+
+/**
+ * @brief Start a scan with explicit parameters without waiting for it
+ *
+ * As wifi_scanner_scan_async(), passing @p params to the driver: active
+ * or passive, dwell time per channel, bands and channels, SSID filters
+ * and the number of access points to report. Zeroed fields keep the
+ * driver default, and drivers ignore what they do not support.
+ *
+ * A scan limited to some bands, channels or SSIDs, or to a number of
+ * access points, sees only part of the neighbourhood. Such a targeted
+ * scan reports every access point it finds through EVT_RESULT, several
+ * of one network included, and does not touch the published results.
+ * Only @p cb hears of it, not the callback registered with
+ * wifi_scanner_set_event_cb(). Passive scans and dwell times alone
+ * still refresh the results.
+ *
+ * @param scanner Pointer to scanner context
+ * @param params Scan parameters, or NULL for a full scan with driver
+ *               defaults; only read before the call returns
+ * @param timeout_ms Timeout in milliseconds (0 = use default 10s)
+ * @param cb Progress callback for this scan only, or NULL
+ * @param user_data User data passed to cb
+ * @return 0 if the scan started, -EBUSY if one is in progress or the
+ *         back buffer is still pinned, other negative errno on failure
+ *         (cb then gets no EVT_DONE)
+ */
+int wifi_scanner_scan_params_async(struct wifi_scanner *scanner,
+                                   const struct wifi_scan_params *params,
+                                   uint32_t timeout_ms,
+                                   wifi_scanner_event_cb_t cb, void *user_data);
+
+/**
+ * @brief Fill in parameters probing for one known network
+ *
+ * An active scan for @p ssid on one channel, which takes a fraction of
+ * a sweep over every channel. Suits checking that a known access point
+ * is still where it was before joining or roaming to it.
+ *
+ * @param params Parameters to fill in
+ * @param ssid SSID to probe for; must stay valid until the scan starts
+ * @param band Band of @p channel
+ * @param channel Channel to probe, 0 for every channel
+ */
+void wifi_scanner_params_probe(struct wifi_scan_params *params, const char *ssid,
+                               enum wifi_frequency_bands band, uint8_t channel);
+
+/**
+ * @brief Refresh the results periodically in the background
+ *
+ * Once the published results are @p interval_ms old, a scan is started
+ * when the radio is idle: the station neither joining a network nor
+ * running as an access point.
+ *
+ * @param scanner Pointer to scanner context
+ * @param interval_ms Refresh interval, 0 to stop
+ */
+void wifi_scanner_set_background(struct wifi_scanner *scanner, uint32_t interval_ms);
+
+/**
+ * @brief Register a scan progress callback
+ *
+ * Only one callback is supported; pass NULL to remove it.
+ *
+ * @param scanner Pointer to scanner context
+ * @param cb Callback, or NULL
+ * @param user_data User data passed to the callback
+ */
+void wifi_scanner_set_event_cb(struct wifi_scanner *scanner,
+                               wifi_scanner_event_cb_t cb, void *user_data);
+
+/**
+ * @brief Pin the published scan results
+ *
+ * The snapshot stays unchanged until released with
+ * wifi_scanner_snapshot_put(), even if scans complete meanwhile. Results
+ * are sorted by signal strength, strongest first. Pins are meant to be
+ * short: a new scan cannot start while an older snapshot is pinned.
+ *
+ * @param scanner Pointer to scanner context
+ * @return Published snapshot, never NULL
+ */
+const struct wifi_scan_snapshot *wifi_scanner_snapshot_get(struct wifi_scanner *scanner);
+
+/**
+ * @brief Pin the published scan results, refreshing them if too old
+ *
+ * Never waits for the radio: the current snapshot is returned at once,
+ * and if it is older than @p max_age_ms an asynchronous scan is started
+ * (unless one is running). Its results are published with EVT_DONE.
+ *
+ * @param scanner Pointer to scanner context
+ * @param max_age_ms Oldest results the caller is content with
+ * @return Published snapshot, never NULL; release it with
+ *         wifi_scanner_snapshot_put()
+ */
+const struct wifi_scan_snapshot *wifi_scanner_snapshot_get_fresh(struct wifi_scanner *scanner,
+                                                                 uint32_t max_age_ms);
+
+/**
+ * @brief Get the age of a snapshot
+ *
+ * @param snap Pinned snapshot
+ * @return Milliseconds since its scan completed, UINT32_MAX if no scan
+ *         has completed
+ */
+uint32_t wifi_scanner_snapshot_age_ms(const struct wifi_scan_snapshot *snap);
+
+/**
+ * @brief Get the time since a network was last seen
+ *
+ * @param snap Pinned snapshot
+ * @param index Result index, below snap->count
+ * @return Seconds since the network was last seen, UINT32_MAX if no
+ *         scan has completed
+ */
+uint32_t wifi_scanner_entry_age_s(const struct wifi_scan_snapshot *snap, size_t index);
+
+/**
+ * @brief Get the SSID of a result
+ *
+ * @param snap Pinned snapshot
+ * @param index Result index, below snap->count
+ * @return NUL-terminated SSID, empty for hidden networks; valid while
+ *         the snapshot is pinned
+ */
+const char *wifi_scanner_entry_ssid(const struct wifi_scan_snapshot *snap, size_t index);
+
+/**
+ * @brief Release a snapshot pinned with wifi_scanner_snapshot_get()
+ *
+ * @param snap Snapshot to release
+ */
+void wifi_scanner_snapshot_put(const struct wifi_scan_snapshot *snap);
+
+/**
+ * @brief Get the result set generation
+ *
+ * The value changes whenever a snapshot is published, so consumers can
+ * cache anything derived from the results until it moves.
  *
  * @param scanner Pointer to scanner context
- * @param count Output parameter for number of results
- * @return Pointer to results array, or NULL if no results
+ * @return Current generation
  */
-const struct wifi_scan_result *wifi_scanner_get_results(
-	struct wifi_scanner *scanner, size_t *count);
+uint32_t wifi_scanner_get_generation(struct wifi_scanner *scanner);
 
 /**
  * @brief Clear scan results
  *
+ * Publishes an empty snapshot.
+ *
  * @param scanner Pointer to scanner context
+ * @return 0 on success, -EBUSY while scanning or while the back buffer
+ *         is still pinned
  */
-void wifi_scanner_clear_results(struct wifi_scanner *scanner);
+int wifi_scanner_clear_results(struct wifi_scanner *scanner);
 
 /**
  * @brief Get scanner state
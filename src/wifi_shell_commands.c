@@ -4,11 +4,13 @@
  */
 
 #include "wifi_shell_commands.h"
+#include "wifi_profiles.h"
 #include <zephyr/shell/shell.h>
 #include <zephyr/settings/settings.h>
 #include <zephyr/logging/log.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 LOG_MODULE_REGISTER(wifi_shell, LOG_LEVEL_INF);
 
@@ -32,52 +34,199 @@ static int cmd_wifi_reset(const struct shell *sh, size_t argc, char **argv)
 	return 0;
 }
 
+/**
+ * @brief Progress of a shell-initiated scan
+ */
+struct wifi_shell_scan {
+	const struct shell *sh;
+	struct k_sem done;
+	size_t count;
+	int status;
+};
+
+/**
+ * @brief Print each network as the driver reports it
+ */
+static void wifi_shell_scan_event(enum wifi_scanner_event event,
+                                  const struct wifi_scan_result *result,
+                                  int status, void *user_data)
+{
+	struct wifi_shell_scan *scan = user_data;
+
+	switch (event) {
+	case WIFI_SCANNER_EVT_RESULT:
+		scan->count++;
+		shell_print(scan->sh, "%-32s %4d dBm %2u  %s",
+		            result->ssid,
+		            result->rssi,
+		            result->channel,
+		            wifi_scanner_security_to_string(result->security));
+		break;
+	case WIFI_SCANNER_EVT_DONE:
+		scan->status = status;
+		k_sem_give(&scan->done);
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * @brief Parse a number option argument
+ */
+static int wifi_shell_parse_num(const struct shell *sh, const char *arg,
+                                unsigned long max, unsigned long *value)
+{
+	char *end;
+
+	*value = strtoul(arg, &end, 10);
+	if (end == arg || *end != '\0' || *value > max) {
+		shell_error(sh, "Invalid number: %s", arg);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Parse a channel list such as 1,6,11
+ */
+static int wifi_shell_parse_channels(const struct shell *sh, char *arg,
+                                     struct wifi_scan_params *params)
+{
+	size_t n = 0;
+	char *save;
+
+	for (char *tok = strtok_r(arg, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+		unsigned long chan;
+		int rc;
+
+		if (n >= ARRAY_SIZE(params->band_chan)) {
+			shell_error(sh, "At most %zu channels", ARRAY_SIZE(params->band_chan));
+			return -EINVAL;
+		}
+
+		rc = wifi_shell_parse_num(sh, tok, WIFI_CHANNEL_MAX, &chan);
+		if (rc || chan == 0) {
+			return -EINVAL;
+		}
+
+		params->band_chan[n].band = (chan <= 14) ? WIFI_FREQ_BAND_2_4_GHZ :
+		                                           WIFI_FREQ_BAND_5_GHZ;
+		params->band_chan[n].channel = chan;
+		n++;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Parse scan options into scan parameters
+ *
+ * @return 0 on success, -EINVAL on a bad option
+ */
+static int wifi_shell_scan_params(const struct shell *sh, size_t argc, char **argv,
+                                  struct wifi_scan_params *params)
+{
+	unsigned long value;
+
+	memset(params, 0, sizeof(*params));
+	params->scan_type = WIFI_SCAN_TYPE_ACTIVE;
+
+	for (size_t i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "passive") == 0) {
+			params->scan_type = WIFI_SCAN_TYPE_PASSIVE;
+			continue;
+		}
+
+		if (i + 1 >= argc) {
+			shell_error(sh, "Missing value for %s", argv[i]);
+			return -EINVAL;
+		}
+
+		if (strcmp(argv[i], "ch") == 0) {
+			if (wifi_shell_parse_channels(sh, argv[++i], params)) {
+				return -EINVAL;
+			}
+		} else if (strcmp(argv[i], "dwell") == 0) {
+			if (wifi_shell_parse_num(sh, argv[++i], UINT16_MAX, &value)) {
+				return -EINVAL;
+			}
+			/* Applies to whichever kind of scan is made */
+			params->dwell_time_active = value;
+			params->dwell_time_passive = value;
+		} else if (strcmp(argv[i], "ssid") == 0) {
+			if (strlen(argv[++i]) > WIFI_SSID_MAX_LEN) {
+				shell_error(sh, "SSID too long (max %d)", WIFI_SSID_MAX_LEN);
+				return -EINVAL;
+			}
+			params->ssids[0] = argv[i];
+		} else if (strcmp(argv[i], "max") == 0) {
+			if (wifi_shell_parse_num(sh, argv[++i], UINT16_MAX, &value)) {
+				return -EINVAL;
+			}
+			params->max_bss_cnt = value;
+		} else {
+			shell_error(sh, "Unknown option: %s", argv[i]);
+			return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
 /**
  * @brief Shell command: Scan for WiFi networks
  *
- * Performs a WiFi scan and displays results
+ * Performs a WiFi scan and prints each network as soon as it is found.
+ * Options narrow the scan; a targeted one lists every access point it
+ * finds and leaves the stored results alone.
  */
 static int cmd_wifi_scan(const struct shell *sh, size_t argc, char **argv)
 {
+	struct wifi_shell_scan scan = {
+		.sh = sh,
+	};
+	struct wifi_scan_params params;
 	int rc;
-	size_t count;
-	const struct wifi_scan_result *results;
 
-	ARG_UNUSED(argc);
-	ARG_UNUSED(argv);
+	rc = wifi_shell_scan_params(sh, argc, argv, &params);
+	if (rc) {
+		return rc;
+	}
 
 	if (!g_scanner) {
 		shell_error(sh, "WiFi scanner not initialized");
 		return -ENOTSUP;
 	}
 
-	shell_print(sh, "Scanning for WiFi networks...");
+	k_sem_init(&scan.done, 0, 1);
 
-	rc = wifi_scanner_scan(g_scanner, 10000);
+	shell_print(sh, "Scanning for WiFi networks...\n");
+	shell_print(sh, "%-32s %6s %4s %s", "SSID", "Signal", "Ch", "Security");
+	shell_print(sh, "%-32s %6s %4s %s", "----", "------", "--", "--------");
+
+	rc = wifi_scanner_scan_params_async(g_scanner, (argc > 1) ? &params : NULL, 10000,
+	                                    wifi_shell_scan_event, &scan);
 	if (rc) {
 		shell_error(sh, "Scan failed: %d", rc);
 		return rc;
 	}
 
-	results = wifi_scanner_get_results(g_scanner, &count);
-	if (!results || count == 0) {
-		shell_print(sh, "No networks found");
-		return 0;
-	}
+	/* The scanner always reports EVT_DONE, at the latest on its timeout */
+	k_sem_take(&scan.done, K_FOREVER);
 
-	shell_print(sh, "\nFound %zu networks:\n", count);
-	shell_print(sh, "%-32s %6s %4s %s", "SSID", "Signal", "Ch", "Security");
-	shell_print(sh, "%-32s %6s %4s %s", "----", "------", "--", "--------");
+	if (scan.status) {
+		shell_error(sh, "Scan failed: %d", scan.status);
+		return scan.status;
+	}
 
-	for (size_t i = 0; i < count; i++) {
-		shell_print(sh, "%-32s %4d dBm %2u  %s",
-		            results[i].ssid,
-		            results[i].rssi,
-		            results[i].channel,
-		            wifi_scanner_security_to_string(results[i].security));
+	if (scan.count == 0) {
+		shell_print(sh, "No networks found");
+		return 0;
 	}
 
-	shell_print(sh, "");
+	shell_print(sh, "\nFound %zu networks", scan.count);
 	return 0;
 }
 
@@ -142,6 +291,75 @@ static int cmd_wifi_provision_stop(const struct shell *sh, size_t argc, char **a
 	return 0;
 }
 
+/**
+ * @brief Shell command: List stored network profiles
+ */
+static int cmd_wifi_profiles(const struct shell *sh, size_t argc, char **argv)
+{
+	struct wifi_profile profile;
+	size_t shown = 0;
+
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	shell_print(sh, "%-4s %-32s %8s %5s %5s %9s", "Slot", "SSID", "Last", "OK",
+	            "Fail", "Avg (ms)");
+
+	for (size_t i = 0; i < WIFI_PROFILES_MAX; i++) {
+		if (wifi_profiles_get(i, &profile)) {
+			continue;
+		}
+
+		shell_print(sh, "%-4u %-32s %8u %5u %5u %9u", (unsigned int)i,
+		            profile.ssid, profile.stats.last_success,
+		            profile.stats.successes, profile.stats.failures,
+		            profile.stats.avg_connect_ms);
+		shown++;
+	}
+
+	if (shown == 0) {
+		shell_print(sh, "No profiles stored");
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Shell command: Add or update a network profile
+ */
+static int cmd_wifi_profile_add(const struct shell *sh, size_t argc, char **argv)
+{
+	int rc;
+
+	rc = wifi_profiles_add(argv[1], argc > 2 ? argv[2] : "");
+	if (rc < 0) {
+		shell_error(sh, "Failed to store profile: %d", rc);
+		return rc;
+	}
+
+	shell_print(sh, "Profile '%s' stored in slot %d", argv[1], rc);
+	return 0;
+}
+
+/**
+ * @brief Shell command: Remove a network profile
+ */
+static int cmd_wifi_profile_remove(const struct shell *sh, size_t argc, char **argv)
+{
+	int rc;
+
+	ARG_UNUSED(argc);
+
+	rc = wifi_profiles_remove(argv[1]);
+	if (rc) {
+		shell_error(sh, "No profile for '%s'", argv[1]);
+		return rc;
+	}
+
+	shell_print(sh, "Profile '%s' removed", argv[1]);
+	return 0;
+}
+
 /**
  * @brief Shell command: Clear all settings and reboot
  *
@@ -165,15 +383,25 @@ SHELL_STATIC_SUBCMD_SET_CREATE(wifi_ext_cmds,
 	SHELL_CMD(reset, NULL,
 	          "Clear stored WiFi credentials",
 	          cmd_wifi_reset),
-	SHELL_CMD(scan, NULL,
-	          "Scan for available WiFi networks",
-	          cmd_wifi_scan),
+	SHELL_CMD_ARG(scan, NULL,
+	              "Scan for available WiFi networks: scan [passive] [ch <n>[,<n>...]] "
+	              "[dwell <ms>] [ssid <name>] [max <n>]",
+	              cmd_wifi_scan, 1, 9),
 	SHELL_CMD(provision, NULL,
 	          "Start AP provisioning mode",
 	          cmd_wifi_provision),
 	SHELL_CMD(provision_stop, NULL,
 	          "Stop AP provisioning mode",
 	          cmd_wifi_provision_stop),
+	SHELL_CMD(profiles, NULL,
+	          "List stored networks and their connect history",
+	          cmd_wifi_profiles),
+	SHELL_CMD_ARG(profile_add, NULL,
+	              "Store a network: profile_add <ssid> [password]",
+	              cmd_wifi_profile_add, 2, 1),
+	SHELL_CMD_ARG(profile_remove, NULL,
+	              "Forget a network: profile_remove <ssid>",
+	              cmd_wifi_profile_remove, 2, 0),
 	SHELL_CMD(factory_reset, NULL,
 	          "Factory reset (clear all settings)",
 	          cmd_wifi_factory_reset),
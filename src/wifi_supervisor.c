@@ -0,0 +1,212 @@
+/**
+ * @file wifi_supervisor.c
+ * @brief Automatic WiFi reconnection implementation
+ */
+
+#include "wifi_supervisor.h"
+#include <zephyr/random/random.h>
+#include <zephyr/logging/log.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(wifi_supervisor, LOG_LEVEL_INF);
+
+/* Time allowed for a connect result; the fast attempt skips the scan */
+#define WIFI_SUPERVISOR_FAST_TIMEOUT_MS    5000
+#define WIFI_SUPERVISOR_CONNECT_TIMEOUT_MS 30000
+
+static const uint32_t recover_bounds_ms[WIFI_SUPERVISOR_HIST_BUCKETS - 1] = {
+	1000, 2000, 5000, 10000, 30000, 60000, 300000
+};
+
+/**
+ * @brief Get the delay before the next attempt
+ *
+ * Doubles from CONFIG_SLIDER_WIFI_RECONNECT_MIN_MS with each attempt up
+ * to CONFIG_SLIDER_WIFI_RECONNECT_MAX_MS, then picks a random point in
+ * the upper half of that window.
+ */
+static uint32_t wifi_supervisor_backoff_ms(uint32_t attempt)
+{
+	uint32_t delay = CONFIG_SLIDER_WIFI_RECONNECT_MIN_MS;
+
+	/* attempt is at least 1 here; the fast attempt is not delayed */
+	for (uint32_t i = 1; i < attempt && delay < CONFIG_SLIDER_WIFI_RECONNECT_MAX_MS; i++) {
+		delay *= 2;
+	}
+	delay = MIN(delay, CONFIG_SLIDER_WIFI_RECONNECT_MAX_MS);
+
+	return delay / 2 + sys_rand32_get() % (delay / 2 + 1);
+}
+
+/**
+ * @brief Count a failed attempt and schedule the next one
+ *
+ * Called with the lock held.
+ */
+static void wifi_supervisor_retry(struct wifi_supervisor *sup)
+{
+	uint32_t delay = wifi_supervisor_backoff_ms(sup->attempt);
+
+	sup->stats.failures++;
+	sup->state = WIFI_SUPERVISOR_BACKOFF;
+	k_work_reschedule(&sup->work, K_MSEC(delay));
+
+	LOG_INF("Reconnect attempt %u failed, next in %u ms", sup->attempt, delay);
+}
+
+static void wifi_supervisor_work(struct k_work *work)
+{
+	struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+	struct wifi_supervisor *sup = CONTAINER_OF(dwork, struct wifi_supervisor, work);
+	k_spinlock_key_t key;
+	bool fast;
+	int rc;
+
+	key = k_spin_lock(&sup->lock);
+
+	if (sup->state == WIFI_SUPERVISOR_CONNECTING) {
+		/* No result in time */
+		LOG_WRN("Reconnect attempt %u timed out", sup->attempt);
+		wifi_supervisor_retry(sup);
+		k_spin_unlock(&sup->lock, key);
+		return;
+	}
+
+	if (sup->state != WIFI_SUPERVISOR_BACKOFF) {
+		k_spin_unlock(&sup->lock, key);
+		return;
+	}
+
+	fast = (sup->attempt == 0);
+	sup->attempt++;
+	sup->stats.attempts++;
+	sup->state = WIFI_SUPERVISOR_CONNECTING;
+	k_spin_unlock(&sup->lock, key);
+
+	rc = sup->connect_cb(fast, sup->user_data);
+	if (rc == -ENOENT && fast) {
+		/* Nothing learned to target; go straight to a full connect */
+		fast = false;
+		rc = sup->connect_cb(false, sup->user_data);
+	}
+
+	key = k_spin_lock(&sup->lock);
+
+	/* The result may already have arrived */
+	if (sup->state == WIFI_SUPERVISOR_CONNECTING) {
+		if (rc == 0) {
+			k_work_reschedule(&sup->work,
+			                  K_MSEC(fast ? WIFI_SUPERVISOR_FAST_TIMEOUT_MS :
+			                         WIFI_SUPERVISOR_CONNECT_TIMEOUT_MS));
+		} else if (rc == -EBUSY || rc == -EALREADY || rc == -EAGAIN) {
+			wifi_supervisor_retry(sup);
+		} else {
+			LOG_ERR("Reconnect request failed: %d, giving up", rc);
+			sup->state = WIFI_SUPERVISOR_IDLE;
+		}
+	}
+
+	k_spin_unlock(&sup->lock, key);
+}
+
+void wifi_supervisor_init(struct wifi_supervisor *sup,
+                          wifi_supervisor_connect_cb_t connect_cb,
+                          void *user_data)
+{
+	memset(sup, 0, sizeof(*sup));
+	sup->state = WIFI_SUPERVISOR_IDLE;
+	sup->connect_cb = connect_cb;
+	sup->user_data = user_data;
+	k_work_init_delayable(&sup->work, wifi_supervisor_work);
+}
+
+void wifi_supervisor_connect_result(struct wifi_supervisor *sup, int status)
+{
+	k_spinlock_key_t key = k_spin_lock(&sup->lock);
+
+	if (status == 0) {
+		if (sup->state == WIFI_SUPERVISOR_BACKOFF ||
+		    sup->state == WIFI_SUPERVISOR_CONNECTING) {
+			uint32_t ms = (uint32_t)(k_uptime_get() - sup->down_since);
+			size_t bucket = 0;
+
+			while (bucket < ARRAY_SIZE(recover_bounds_ms) &&
+			       ms >= recover_bounds_ms[bucket]) {
+				bucket++;
+			}
+
+			sup->stats.recoveries++;
+			sup->stats.recover_hist[bucket]++;
+			sup->stats.last_recover_ms = ms;
+			sup->stats.max_recover_ms = MAX(sup->stats.max_recover_ms, ms);
+
+			LOG_INF("Link recovered after %u ms, %u attempt(s)", ms, sup->attempt);
+		}
+
+		sup->state = WIFI_SUPERVISOR_CONNECTED;
+		k_work_cancel_delayable(&sup->work);
+	} else if (sup->state == WIFI_SUPERVISOR_CONNECTING) {
+		wifi_supervisor_retry(sup);
+	}
+
+	k_spin_unlock(&sup->lock, key);
+}
+
+void wifi_supervisor_link_down(struct wifi_supervisor *sup)
+{
+	k_spinlock_key_t key = k_spin_lock(&sup->lock);
+
+	if (sup->state == WIFI_SUPERVISOR_CONNECTED) {
+		sup->stats.disconnects++;
+		sup->down_since = k_uptime_get();
+		sup->attempt = 0;
+		sup->state = WIFI_SUPERVISOR_BACKOFF;
+
+		/* The fast attempt goes out at once */
+		k_work_reschedule(&sup->work, K_NO_WAIT);
+		LOG_WRN("Link lost, reconnecting");
+	}
+
+	k_spin_unlock(&sup->lock, key);
+}
+
+void wifi_supervisor_disarm(struct wifi_supervisor *sup)
+{
+	k_spinlock_key_t key = k_spin_lock(&sup->lock);
+
+	sup->state = WIFI_SUPERVISOR_IDLE;
+	k_work_cancel_delayable(&sup->work);
+
+	k_spin_unlock(&sup->lock, key);
+}
+
+enum wifi_supervisor_state wifi_supervisor_get_state(struct wifi_supervisor *sup)
+{
+	return sup->state;
+}
+
+void wifi_supervisor_get_stats(struct wifi_supervisor *sup,
+                               struct wifi_supervisor_stats *stats)
+{
+	k_spinlock_key_t key = k_spin_lock(&sup->lock);
+
+	*stats = sup->stats;
+
+	k_spin_unlock(&sup->lock, key);
+}
+
+const char *wifi_supervisor_state_to_string(enum wifi_supervisor_state state)
+{
+	switch (state) {
+	case WIFI_SUPERVISOR_IDLE:
+		return "idle";
+	case WIFI_SUPERVISOR_CONNECTED:
+		return "connected";
+	case WIFI_SUPERVISOR_BACKOFF:
+		return "backoff";
+	case WIFI_SUPERVISOR_CONNECTING:
+		return "connecting";
+	default:
+		return "unknown";
+	}
+}
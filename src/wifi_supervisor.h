@@ -0,0 +1,152 @@
+/**
+ * @file wifi_supervisor.h
+ * @brief Automatic WiFi reconnection
+ *
+ * When the station loses its access point, the supervisor reconnects on
+ * its own instead of waiting for 'wifi connect'. The first retry goes
+ * straight to the last access point on its channel; later retries join
+ * on any channel, spaced by an exponential backoff with random jitter
+ * (CONFIG_SLIDER_WIFI_RECONNECT_MIN_MS up to _MAX_MS) so a room full of
+ * devices does not hammer a recovering access point in step.
+ *
+ * Work runs on the system work queue and never blocks: connect requests
+ * are only issued there, and their results arrive through
+ * wifi_supervisor_connect_result().
+ */
+
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Recovery time histogram buckets; the last one is open-ended */
+#define WIFI_SUPERVISOR_HIST_BUCKETS 8
+
+/**
+ * @brief Supervisor state
+ */
+enum wifi_supervisor_state {
+	WIFI_SUPERVISOR_IDLE,       /**< Not connected yet, or gave up */
+	WIFI_SUPERVISOR_CONNECTED,  /**< Link up, watching for a disconnect */
+	WIFI_SUPERVISOR_BACKOFF,    /**< Waiting before the next attempt */
+	WIFI_SUPERVISOR_CONNECTING  /**< Attempt issued, waiting for its result */
+};
+
+/**
+ * @brief Connect request callback
+ *
+ * Issues an asynchronous connect request and returns without waiting
+ * for the result. Runs on the system work queue.
+ *
+ * @param fast true to target the last access point and channel only
+ * @param user_data User data pointer
+ * @return 0 if the request was issued, -ENOENT if a fast attempt is not
+ *         possible (the supervisor then tries a full connect at once),
+ *         -EBUSY, -EALREADY or -EAGAIN to back off and retry, any other
+ *         negative errno to stop reconnecting
+ */
+typedef int (*wifi_supervisor_connect_cb_t)(bool fast, void *user_data);
+
+/**
+ * @brief Reconnection metrics
+ */
+struct wifi_supervisor_stats {
+	uint32_t disconnects;   /**< Unexpected link losses */
+	uint32_t recoveries;    /**< Losses followed by a reconnect */
+	uint32_t attempts;      /**< Connect requests issued */
+	uint32_t failures;      /**< Attempts that failed or timed out */
+	uint32_t last_recover_ms;
+	uint32_t max_recover_ms;
+	/** Time to recover, bucket upper bounds 1, 2, 5, 10, 30, 60, 300 s */
+	uint32_t recover_hist[WIFI_SUPERVISOR_HIST_BUCKETS];
+};
+
+/**
+ * @brief Supervisor context
+ */
+struct wifi_supervisor {
+	enum wifi_supervisor_state state;
+	wifi_supervisor_connect_cb_t connect_cb;
+	void *user_data;
+	struct k_work_delayable work;
+	struct k_spinlock lock;
+	uint32_t attempt;       /**< Attempts since the link was lost */
+	int64_t down_since;     /**< Uptime the link was lost (ms) */
+	struct wifi_supervisor_stats stats;
+};
+
+/**
+ * @brief Initialize the supervisor
+ *
+ * @param sup Pointer to supervisor context
+ * @param connect_cb Issues connect requests
+ * @param user_data User data passed to the callback
+ */
+void wifi_supervisor_init(struct wifi_supervisor *sup,
+                          wifi_supervisor_connect_cb_t connect_cb,
+                          void *user_data);
+
+/**
+ * @brief Report a connect result
+ *
+ * Call from the NET_EVENT_WIFI_CONNECT_RESULT handler for every result,
+ * including connects the supervisor did not start; a successful one
+ * arms the supervisor.
+ *
+ * @param sup Pointer to supervisor context
+ * @param status 0 on success, driver status otherwise
+ */
+void wifi_supervisor_connect_result(struct wifi_supervisor *sup, int status);
+
+/**
+ * @brief Report a link loss
+ *
+ * Call from the NET_EVENT_WIFI_DISCONNECT_RESULT handler. Ignored unless
+ * the link was up.
+ *
+ * @param sup Pointer to supervisor context
+ */
+void wifi_supervisor_link_down(struct wifi_supervisor *sup);
+
+/**
+ * @brief Stop reconnecting until the next successful connect
+ *
+ * For disconnects the application asks for, such as clearing the
+ * credentials. Call before requesting the disconnect.
+ *
+ * @param sup Pointer to supervisor context
+ */
+void wifi_supervisor_disarm(struct wifi_supervisor *sup);
+
+/**
+ * @brief Get the current state
+ *
+ * @param sup Pointer to supervisor context
+ * @return Current state
+ */
+enum wifi_supervisor_state wifi_supervisor_get_state(struct wifi_supervisor *sup);
+
+/**
+ * @brief Copy the reconnection metrics
+ *
+ * @param sup Pointer to supervisor context
+ * @param stats Output metrics
+ */
+void wifi_supervisor_get_stats(struct wifi_supervisor *sup,
+                               struct wifi_supervisor_stats *stats);
+
+/**
+ * @brief Get a printable state name
+ *
+ * @param state State
+ * @return State name
+ */
+const char *wifi_supervisor_state_to_string(enum wifi_supervisor_state state);
+
+#ifdef __cplusplus
+}
+#endif
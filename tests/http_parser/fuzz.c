@@ -0,0 +1,261 @@
+/**
+ * @file fuzz.c
+ * @brief Fuzz target for the incremental HTTP request parser
+ *
+ * Each input is parsed the way the server sees it: copied into a
+ * receive buffer of CONFIG_SLIDER_HTTP_RX_BUF_SIZE bytes, once in a
+ * single piece and once in segments of varying size. The target checks
+ * that:
+ *
+ * - both ways give the same result and the same fields, so resuming
+ *   never changes the outcome;
+ * - spans and lengths of a parsed request stay inside the buffer;
+ * - a full buffer is never left incomplete while still in the headers,
+ *   which would leave the server reading zero bytes instead of
+ *   answering 431;
+ * - the form decoder always terminates and bounds its output.
+ *
+ * Built with -fsanitize=fuzzer, this is a libFuzzer target. Otherwise
+ * main() replays the files named on the command line and, with
+ * -m <rounds>, also runs that many random mutations of each. -x <result>
+ * makes the files that follow fail unless parsing them gives <result>:
+ * DONE, INCOMPLETE, EBADMSG, EMSGSIZE or ENOTSUP.
+ */
+
+#include "http_parser.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RX_BUF_SIZE 1024
+#define MAX_BODY    512
+
+/* Result of the last whole-buffer parse, for main() to check */
+static int last_ret;
+
+/**
+ * @brief Feed a request in segments, as successive recv() calls would
+ */
+static int parse_segmented(struct http_parser *parser, const char *buf, size_t len,
+                           unsigned int seed)
+{
+	size_t avail = 0;
+	int ret = HTTP_PARSE_INCOMPLETE;
+
+	http_parser_init(parser, RX_BUF_SIZE, MAX_BODY);
+
+	while (avail < len) {
+		seed = seed * 1103515245u + 12345u;
+		avail = MIN(len, avail + 1 + (seed >> 16) % 64);
+
+		ret = http_parser_execute(parser, buf, avail);
+		if (ret != HTTP_PARSE_INCOMPLETE) {
+			break;
+		}
+	}
+
+	return ret;
+}
+
+static void check_request(const struct http_parser *parser, const char *buf, size_t len)
+{
+	size_t req_len = http_parser_request_len(parser);
+
+	assert(req_len <= len);
+	assert(parser->body_off <= req_len);
+	assert(parser->path.len > 0);
+	assert(parser->path.off + parser->path.len <= parser->body_off);
+
+	for (int i = 0; i < HTTP_HDR_COUNT; i++) {
+		assert(parser->headers[i].off + parser->headers[i].len <= parser->body_off);
+	}
+
+	/* Exercised on every request, not only ones carrying a form */
+	(void)http_parser_header_has(parser, buf, HTTP_HDR_CONNECTION, "close");
+	(void)http_parser_etag_match(parser, buf, "\"0123456789abcdef\"");
+}
+
+static void check_form(const char *body, size_t len)
+{
+	char out[33];
+	int n = http_form_get(body, len, "ssid", out, sizeof(out));
+
+	if (n >= 0) {
+		assert((size_t)n < sizeof(out));
+		assert(out[n] == '\0');
+	} else {
+		assert(n == -ENOENT);
+	}
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	char buf[RX_BUF_SIZE];
+	size_t len = MIN(size, sizeof(buf));
+	struct http_parser whole;
+	struct http_parser seg;
+	int ret_whole;
+	int ret_seg;
+
+	memcpy(buf, data, len);
+
+	http_parser_init(&whole, sizeof(buf), MAX_BODY);
+	ret_whole = http_parser_execute(&whole, buf, len);
+	ret_seg = parse_segmented(&seg, buf, len, (unsigned int)size);
+
+	assert(ret_whole == ret_seg);
+	last_ret = ret_whole;
+
+	if (ret_whole == HTTP_PARSE_INCOMPLETE) {
+		/* More data must be able to arrive */
+		assert(len < sizeof(buf) || whole.state >= HTTP_PARSER_BODY);
+		return 0;
+	}
+
+	if (ret_whole < 0) {
+		assert(ret_whole == -EBADMSG || ret_whole == -EMSGSIZE ||
+		       ret_whole == -ENOTSUP);
+		return 0;
+	}
+
+	assert(whole.method == seg.method);
+	assert(memcmp(&whole.path, &seg.path, sizeof(whole.path)) == 0);
+	assert(memcmp(whole.headers, seg.headers, sizeof(whole.headers)) == 0);
+	assert(whole.content_length == seg.content_length);
+	assert(whole.body_off == seg.body_off);
+
+	check_request(&whole, buf, len);
+	check_form(buf + whole.body_off, whole.content_length);
+
+	return 0;
+}
+
+#ifndef HTTP_PARSER_LIBFUZZER
+
+static size_t read_file(const char *path, uint8_t *buf, size_t size)
+{
+	FILE *f = fopen(path, "rb");
+	size_t n;
+
+	if (!f) {
+		perror(path);
+		exit(1);
+	}
+
+	n = fread(buf, 1, size, f);
+	fclose(f);
+
+	return n;
+}
+
+static int parse_result(const char *name)
+{
+	static const struct {
+		const char *name;
+		int ret;
+	} results[] = {
+		{ "DONE", HTTP_PARSE_DONE },
+		{ "INCOMPLETE", HTTP_PARSE_INCOMPLETE },
+		{ "EBADMSG", -EBADMSG },
+		{ "EMSGSIZE", -EMSGSIZE },
+		{ "ENOTSUP", -ENOTSUP },
+	};
+
+	for (size_t i = 0; i < ARRAY_SIZE(results); i++) {
+		if (strcmp(name, results[i].name) == 0) {
+			return results[i].ret;
+		}
+	}
+
+	fprintf(stderr, "unknown result %s\n", name);
+	exit(1);
+}
+
+/**
+ * @brief Apply one random edit: flip, insert, delete or duplicate bytes
+ */
+static size_t mutate(uint8_t *buf, size_t len, size_t size)
+{
+	size_t pos = len ? (size_t)rand() % len : 0;
+	size_t n = 1 + rand() % 16;
+
+	switch (rand() % 4) {
+	case 0:
+		if (len) {
+			buf[pos] ^= 1u << (rand() % 8);
+		}
+		break;
+	case 1:
+		n = MIN(n, size - len);
+		memmove(&buf[pos + n], &buf[pos], len - pos);
+		for (size_t i = 0; i < n; i++) {
+			buf[pos + i] = "\r\n :,;=&%+aZ0\t"[rand() % 15];
+		}
+		len += n;
+		break;
+	case 2:
+		n = MIN(n, len - pos);
+		memmove(&buf[pos], &buf[pos + n], len - pos - n);
+		len -= n;
+		break;
+	default:
+		/* Grow the header block towards and past the buffer size */
+		n = MIN(len - pos, size - len);
+		memmove(&buf[pos + n], &buf[pos], len - pos);
+		len += n;
+		break;
+	}
+
+	return len;
+}
+
+int main(int argc, char **argv)
+{
+	static uint8_t seed[4 * RX_BUF_SIZE];
+	static uint8_t work[4 * RX_BUF_SIZE];
+	unsigned long rounds = 0;
+	bool check = false;
+	int expect = 0;
+	int files = 0;
+
+	srand(1);
+
+	for (int i = 1; i < argc; i++) {
+		size_t len;
+
+		if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+			rounds = strtoul(argv[++i], NULL, 10);
+			continue;
+		}
+		if (strcmp(argv[i], "-x") == 0 && i + 1 < argc) {
+			expect = parse_result(argv[++i]);
+			check = true;
+			continue;
+		}
+
+		len = read_file(argv[i], seed, sizeof(seed));
+		LLVMFuzzerTestOneInput(seed, len);
+		if (check && last_ret != expect) {
+			fprintf(stderr, "%s: parsed to %d, expected %d\n", argv[i],
+			        last_ret, expect);
+			return 1;
+		}
+		files++;
+
+		for (unsigned long r = 0; r < rounds; r++) {
+			size_t wlen = len;
+
+			memcpy(work, seed, len);
+			for (int m = 1 + rand() % 4; m > 0; m--) {
+				wlen = mutate(work, wlen, sizeof(work));
+			}
+			LLVMFuzzerTestOneInput(work, wlen);
+		}
+	}
+
+	printf("%d inputs, %lu mutations each: ok\n", files, rounds);
+	return 0;
+}
+
+#endif /* HTTP_PARSER_LIBFUZZER */
@@ -0,0 +1,34 @@
+/* WiFi setup page behaviour. Statements must end with ';' because the
+ * build joins lines when minifying.
+ */
+function selectNetwork(ssid) {
+	document.getElementById('ssid').value = ssid;
+}
+
+/* Live device state pushed over /ws. State frames start with type 0x01,
+ * followed by the WiFi state (9 = connected) and the RSSI.
+ */
+function connectLive() {
+	var el = document.getElementById('live');
+	var ws;
+
+	if (!el || !window.WebSocket) {
+		return;
+	}
+
+	ws = new WebSocket('ws://' + location.host + '/ws');
+	ws.binaryType = 'arraybuffer';
+	ws.onmessage = function (ev) {
+		var d = new DataView(ev.data);
+
+		if (d.byteLength >= 12 && d.getUint8(0) === 1) {
+			el.textContent = (d.getUint8(1) === 9 ? 'Connected' : 'Not connected') +
+				', RSSI ' + d.getInt8(2) + ' dBm';
+		}
+	};
+	ws.onclose = function () {
+		setTimeout(connectLive, 5000);
+	};
+}
+
+connectLive();